@@ -0,0 +1,129 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host check of InputGeometry and CoordMapping,the letterbox
+ *               sizes and pads of the model inputs and the mapping of the
+ *               letterboxed content back to the display. make host_check,
+ *               exits 1 on a failure.
+ ***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include "coord_mapping.hpp"
+
+#define CHECK_TOLERANCE (0.01f) //display pixels
+
+static int failures = 0;
+
+static void Expect(bool ok, const char *what, const char *name)
+{
+    if (ok)
+        return;
+    printf("failed:%s:%s\n", name, what);
+    failures++;
+}
+
+static bpu_image_info_t ImageInfo(int model_w, int model_h, int display_w, int display_h)
+{
+    bpu_image_info_t image_info;
+    image_info.m_model_w = model_w;
+    image_info.m_model_h = model_h;
+    image_info.m_ori_width = display_w;
+    image_info.m_ori_height = display_h;
+    return image_info;
+}
+
+/**
+ * The content must be even,inside the input,centered to the pixel pair and
+ * of the source aspect ratio,its corners must land on the display corners.
+ */
+static void CheckLetterbox(const char *name, int model_w, int model_h, int display_w, int display_h, int source_w,
+                           int source_h, int resize_w, int resize_h, int pad_x, int pad_y)
+{
+    bpu_image_info_t image_info = ImageInfo(model_w, model_h, display_w, display_h);
+    InputGeometry geometry = InputGeometry::Letterbox(image_info, source_w, source_h);
+    printf("%s:%dx%d at %d,%d\n", name, geometry.resize_width, geometry.resize_height, geometry.pad_x, geometry.pad_y);
+    Expect(geometry.resize_width == resize_w && geometry.resize_height == resize_h, "resize size", name);
+    Expect(geometry.pad_x == pad_x && geometry.pad_y == pad_y, "pads", name);
+    Expect(geometry.resize_width % 2 == 0 && geometry.resize_height % 2 == 0, "even resize size", name);
+    Expect(geometry.pad_x % 2 == 0 && geometry.pad_y % 2 == 0, "even pads", name);
+    Expect(geometry.pad_x + geometry.resize_width <= model_w && geometry.pad_y + geometry.resize_height <= model_h,
+           "content inside the input", name);
+    Expect(geometry.resize_width == model_w || geometry.resize_height == model_h, "content touches two sides", name);
+    Expect(abs(model_w - geometry.resize_width - 2 * geometry.pad_x) <= 3 &&
+               abs(model_h - geometry.resize_height - 2 * geometry.pad_y) <= 3,
+           "content centered", name);
+    if (source_w > 0 && source_h > 0)
+        Expect(fabs(geometry.resize_width * 1.0 / geometry.resize_height - source_w * 1.0 / source_h) <
+                   2.0 * source_w / source_h / std::min(geometry.resize_width, geometry.resize_height),
+               "source aspect ratio", name);
+    Expect(geometry.crop_x == 0 && geometry.crop_y == 0 && geometry.crop_width == display_w &&
+               geometry.crop_height == display_h,
+           "the whole display is cropped", name);
+
+    CoordMapping mapping = CoordMapping::Build(geometry);
+    Expect(fabs(mapping.ModelX(0) - geometry.pad_x) < CHECK_TOLERANCE &&
+               fabs(mapping.ModelY(0) - geometry.pad_y) < CHECK_TOLERANCE,
+           "display 0,0 is the content corner", name);
+
+    DetectionBatch batch;
+    batch.Reserve(3);
+    //the content,a box of the border only,a box hanging over the border
+    float x0 = geometry.pad_x, y0 = geometry.pad_y;
+    float x1 = x0 + geometry.resize_width, y1 = y0 + geometry.resize_height;
+    batch.Push(0, x0, y0, x1, y1, 1.0f);
+    if (geometry.pad_x > 0)
+        batch.Push(1, 0, y0, x0 - 1, y1, 1.0f);
+    else
+        batch.Push(1, x0, 0, x1, y0 - 1, 1.0f);
+    batch.Push(2, x0 - 4, y0 - 4, x0 + 4, y0 + 4, 1.0f);
+    mapping.Apply(batch);
+    Expect(batch.Size() == 2 && batch.Id()[0] == 0 && batch.Id()[1] == 2, "the border box is dropped", name);
+    if (batch.Size() < 2)
+        return;
+    Expect(fabs(batch.XMin()[0]) < CHECK_TOLERANCE && fabs(batch.YMin()[0]) < CHECK_TOLERANCE,
+           "content top left -> 0,0", name);
+    Expect(fabs(batch.XMax()[0] - (display_w - 1)) < CHECK_TOLERANCE &&
+               fabs(batch.YMax()[0] - (display_h - 1)) < CHECK_TOLERANCE,
+           "content bottom right -> display - 1", name);
+    Expect(batch.XMin()[1] == 0 && batch.YMin()[1] == 0 && batch.XMax()[1] > 0 && batch.YMax()[1] > 0,
+           "a box over the border is clipped to the display", name);
+}
+
+static void CheckStretch()
+{
+    bpu_image_info_t image_info = ImageInfo(300, 300, 1920, 1080);
+    InputGeometry geometry = InputGeometry::Stretch(image_info);
+    CoordMapping mapping = CoordMapping::Build(geometry);
+    DetectionBatch batch;
+    batch.Reserve(1);
+    batch.Push(0, 0, 0, 300, 300, 1.0f);
+    mapping.Apply(batch);
+    Expect(batch.Size() == 1 && batch.XMin()[0] == 0 && batch.YMin()[0] == 0 &&
+               fabs(batch.XMax()[0] - 1919) < CHECK_TOLERANCE && fabs(batch.YMax()[0] - 1079) < CHECK_TOLERANCE,
+           "the whole input -> the whole display", "stretch");
+}
+
+int main()
+{
+    //the 16:9 sensor on a 1080p display,every letterboxed input size
+    CheckLetterbox("672 1080p", 672, 672, 1920, 1080, 1920, 1080, 672, 378, 0, 146);
+    CheckLetterbox("512 1080p", 512, 512, 1920, 1080, 1920, 1080, 512, 288, 0, 112);
+    CheckLetterbox("416 1080p", 416, 416, 1920, 1080, 1920, 1080, 416, 234, 0, 90);
+    CheckLetterbox("640 1080p", 640, 640, 1920, 1080, 1920, 1080, 640, 360, 0, 140);
+    //headless,the display is the model input
+    CheckLetterbox("672 headless", 672, 672, 672, 672, 1920, 1080, 672, 378, 0, 146);
+    //portrait source,the border goes left and right
+    CheckLetterbox("640 portrait", 640, 640, 1080, 1920, 1080, 1920, 360, 640, 140, 0);
+    //4:3 video shown on a 16:9 display,the display stretches the whole frame
+    CheckLetterbox("512 4:3 video", 512, 512, 1920, 1080, 640, 480, 512, 384, 0, 64);
+    //odd sizes round down to even
+    CheckLetterbox("416 odd source", 416, 416, 1000, 1000, 1001, 333, 416, 138, 0, 138);
+    //unknown source size,the display aspect ratio
+    CheckLetterbox("640 no source", 640, 640, 1280, 720, 0, 0, 640, 360, 0, 140);
+    CheckStretch();
+    printf("geometry check:%d failures\n", failures);
+    return failures ? 1 : 0;
+}
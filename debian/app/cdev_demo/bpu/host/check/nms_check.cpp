@@ -0,0 +1,171 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host check of the grid nms,runs NmsSelect pairwise and
+ *               bucketed in the grid on the same boxes and compares the
+ *               kept indices. make host_check,exits 1 on a mismatch.
+ ***************************************************************************/
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "nms_engine.hpp"
+
+#define CHECK_IMAGE_WIDTH (1920.0f)
+#define CHECK_IMAGE_HEIGHT (1080.0f)
+#define CHECK_CLASSES (80)
+#define CHECK_SEEDS (20) //box sets per kind
+
+struct CheckBoxes
+{
+    std::vector<float> xmin;
+    std::vector<float> ymin;
+    std::vector<float> xmax;
+    std::vector<float> ymax;
+    std::vector<float> score;
+    std::vector<int> id;
+
+    void Push(float x0, float y0, float x1, float y1, float s, int c)
+    {
+        xmin.push_back(x0);
+        ymin.push_back(y0);
+        xmax.push_back(x1);
+        ymax.push_back(y1);
+        score.push_back(s);
+        id.push_back(c);
+    }
+
+    NmsBoxes View() const
+    {
+        return {xmin.data(), ymin.data(), xmax.data(), ymax.data(), score.data(), id.data(), (int)score.size()};
+    }
+};
+
+//scores on a 1/256 step,so the tie order is checked too
+static float Score(std::mt19937 &rng)
+{
+    return std::uniform_int_distribution<int>(1, 256)(rng) / 256.0f;
+}
+
+//boxes anywhere in the image,10~300 px
+static CheckBoxes RandomBoxes(std::mt19937 &rng, int n)
+{
+    std::uniform_real_distribution<float> x(0, CHECK_IMAGE_WIDTH), y(0, CHECK_IMAGE_HEIGHT), size(10, 300);
+    std::uniform_int_distribution<int> cls(0, CHECK_CLASSES - 1);
+    CheckBoxes boxes;
+    for (int i = 0; i < n; i++)
+    {
+        float x0 = x(rng), y0 = y(rng);
+        boxes.Push(x0, y0, x0 + size(rng), y0 + size(rng), Score(rng), cls(rng));
+    }
+    return boxes;
+}
+
+//a few objects,every one found many times a few px apart,as the decoders do
+static CheckBoxes ClusteredBoxes(std::mt19937 &rng, int n)
+{
+    std::uniform_real_distribution<float> x(0, CHECK_IMAGE_WIDTH), y(0, CHECK_IMAGE_HEIGHT), size(20, 400);
+    std::normal_distribution<float> jitter(0, 4);
+    std::uniform_int_distribution<int> cls(0, 3), objects(3, 12);
+    struct Object
+    {
+        float x, y, w, h;
+        int id;
+    };
+    std::vector<Object> object(objects(rng));
+    for (auto &o : object)
+    {
+        o = {x(rng), y(rng), size(rng), size(rng), cls(rng)};
+    }
+    CheckBoxes boxes;
+    for (int i = 0; i < n; i++)
+    {
+        const Object &o = object[i % object.size()];
+        float x0 = o.x + jitter(rng), y0 = o.y + jitter(rng);
+        boxes.Push(x0, y0, x0 + o.w + jitter(rng), y0 + o.h + jitter(rng), Score(rng), o.id);
+    }
+    return boxes;
+}
+
+//boxes hanging over the image border,some far larger than a grid cell
+static CheckBoxes BorderBoxes(std::mt19937 &rng, int n)
+{
+    std::uniform_real_distribution<float> unit(0, 1), size(10, 300), huge(600, 2400);
+    std::uniform_int_distribution<int> cls(0, 7), side(0, 3);
+    CheckBoxes boxes;
+    for (int i = 0; i < n; i++)
+    {
+        float w = i % 16 ? size(rng) : huge(rng);
+        float h = i % 16 ? size(rng) : huge(rng);
+        float x0 = unit(rng) * CHECK_IMAGE_WIDTH - w / 2;
+        float y0 = unit(rng) * CHECK_IMAGE_HEIGHT - h / 2;
+        switch (side(rng))
+        {
+        case 0: x0 = -w / 2; break;
+        case 1: y0 = -h / 2; break;
+        case 2: x0 = CHECK_IMAGE_WIDTH - w / 2; break;
+        default: y0 = CHECK_IMAGE_HEIGHT - h / 2; break;
+        }
+        boxes.Push(x0, y0, x0 + w, y0 + h, Score(rng), cls(rng));
+    }
+    return boxes;
+}
+
+/**
+ * @return whether the pairwise and the grid nms keep the same boxes
+ */
+static bool Compare(const char *kind, int seed, const CheckBoxes &boxes, float iou_threshold, int top_k, bool class_agnostic)
+{
+    NmsBoxes view = boxes.View();
+    NmsParams pairwise = {iou_threshold, top_k, class_agnostic, 0};
+    NmsParams grid = pairwise;
+    grid.grid_min_candidates = 1;
+    std::vector<int> pairwise_keep(std::min(top_k, view.n)), grid_keep(std::min(top_k, view.n));
+    int pairwise_kept = NmsSelect(view, pairwise, pairwise_keep.data());
+    int grid_kept = NmsSelect(view, grid, grid_keep.data());
+    if (pairwise_kept == grid_kept && std::equal(pairwise_keep.begin(), pairwise_keep.begin() + pairwise_kept, grid_keep.begin()))
+        return true;
+    printf("mismatch:%s seed %d,%d boxes,iou %.2f,top_k %d,%s:pairwise kept %d,grid kept %d\n", kind, seed, view.n,
+           iou_threshold, top_k, class_agnostic ? "class agnostic" : "class aware", pairwise_kept, grid_kept);
+    return false;
+}
+
+int main()
+{
+    typedef CheckBoxes (*MakeBoxes)(std::mt19937 &, int);
+    const struct
+    {
+        const char *name;
+        MakeBoxes make;
+    } kinds[] = {{"random", RandomBoxes}, {"clustered", ClusteredBoxes}, {"border", BorderBoxes}};
+    const int sizes[] = {1, 7, 64, 300, 2000};
+    const float iou_thresholds[] = {0.0f, 0.3f, 0.45f, 0.7f};
+
+    int cases = 0, mismatches = 0;
+    for (const auto &kind : kinds)
+    {
+        for (int seed = 0; seed < CHECK_SEEDS; seed++)
+        {
+            std::mt19937 rng(seed);
+            for (int n : sizes)
+            {
+                CheckBoxes boxes = kind.make(rng, n);
+                for (float iou_threshold : iou_thresholds)
+                {
+                    for (int top_k : {n, 100})
+                    {
+                        for (bool class_agnostic : {false, true})
+                        {
+                            cases++;
+                            if (!Compare(kind.name, seed, boxes, iou_threshold, top_k, class_agnostic))
+                                mismatches++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    printf("nms check:%d cases,%d mismatches\n", cases, mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host check of SpscRing,a producer and a consumer thread
+ *               under every overflow policy,the works go through PushWork
+ *               as the pipeline queues them. make host_check,exits 1 on a
+ *               failure.
+ ***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "bpu_tensor_pool.hpp"
+#include "spsc_ring.hpp"
+
+#define CHECK_ITEMS (20000) //works pushed per policy
+#define CHECK_RING_DEPTH (3)
+#define CHECK_TIMEOUT_SEC (60) //a thread still blocked by then is a failure
+
+static int failures = 0;
+
+static void Expect(bool ok, const char *what)
+{
+    if (ok)
+        return;
+    printf("failed:%s\n", what);
+    failures++;
+}
+
+//the lease stands for the frame,its index is the frame sequence
+static bpu_work Work(BpuTensorGroup *group)
+{
+    bpu_work work;
+    work.lease = group;
+    return work;
+}
+
+/**
+ * Every work holds one reference of its lease,the consumer keeps it and
+ * PushWork releases the ones the ring discards. A slow consumer makes the
+ * ring overflow.
+ */
+static void CheckPolicy(const char *name, RingOverflowPolicy policy)
+{
+    std::vector<BpuTensorGroup> groups(CHECK_ITEMS);
+    for (int i = 0; i < CHECK_ITEMS; i++)
+    {
+        groups[i].tensors = nullptr;
+        groups[i].index = i;
+        groups[i].refs.store(1, std::memory_order_relaxed);
+    }
+    BpuTensorPool pool; //only Release() is used,the groups are not its own
+    SpscRing<bpu_work> ring(CHECK_RING_DEPTH, policy);
+
+    std::vector<int> popped;
+    std::thread consumer([&]() {
+        bpu_work work;
+        while (ring.pop(work))
+        {
+            popped.push_back(work.lease->index);
+            if (popped.size() % 64 == 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+    for (int i = 0; i < CHECK_ITEMS; i++)
+    {
+        PushWork(ring, pool, Work(&groups[i]));
+        if (i % 16 == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(20)); //bursts,the ring fills only now and then
+    }
+    ring.close();
+    consumer.join();
+
+    bool fifo = true;
+    for (size_t i = 1; i < popped.size(); i++)
+    {
+        fifo = fifo && popped[i - 1] < popped[i];
+    }
+    std::vector<bool> was_popped(CHECK_ITEMS, false);
+    for (int index : popped)
+    {
+        was_popped[index] = true;
+    }
+    int released = 0;
+    bool exclusive = true; //every work either popped with its lease or released
+    for (int i = 0; i < CHECK_ITEMS; i++)
+    {
+        int refs = groups[i].refs.load(std::memory_order_relaxed);
+        released += refs == 0;
+        exclusive = exclusive && refs == (was_popped[i] ? 1 : 0);
+    }
+    printf("%s:%zu popped,%d released,%llu dropped,high water %zu\n", name, popped.size(), released,
+           (unsigned long long)ring.dropped(), ring.high_water());
+    Expect(fifo, "popped works are in push order");
+    Expect(exclusive, "a work is either popped or its lease released");
+    Expect((uint64_t)released == ring.dropped(), "dropped() counts the released works");
+    Expect(ring.high_water() <= CHECK_RING_DEPTH, "the ring never holds more than its capacity");
+    if (policy == RingOverflowPolicy::kBlock)
+        Expect(popped.size() == CHECK_ITEMS, "block loses nothing");
+    else
+        Expect(released > 0, "the slow consumer made the ring overflow");
+    if (policy == RingOverflowPolicy::kDropOldest)
+        Expect(!popped.empty() && popped.back() == CHECK_ITEMS - 1, "drop oldest keeps the newest work");
+    if (policy == RingOverflowPolicy::kDropNewest)
+        Expect(!popped.empty() && popped.front() == 0, "drop newest keeps the oldest work");
+}
+
+static void CheckClose()
+{
+    //a pop waiting on an empty ring returns false
+    {
+        SpscRing<bpu_work> ring(CHECK_RING_DEPTH);
+        std::atomic<int> result{-1};
+        std::thread consumer([&]() {
+            bpu_work work;
+            result = ring.pop(work) ? 1 : 0;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring.close();
+        consumer.join();
+        Expect(result == 0, "close() releases a blocked pop");
+    }
+    //a push waiting on a full ring fails and its lease is released
+    {
+        BpuTensorGroup groups[CHECK_RING_DEPTH + 1];
+        for (auto &group : groups)
+        {
+            group.tensors = nullptr;
+            group.index = 0;
+            group.refs.store(1, std::memory_order_relaxed);
+        }
+        BpuTensorPool pool;
+        SpscRing<bpu_work> ring(CHECK_RING_DEPTH, RingOverflowPolicy::kBlock);
+        for (int i = 0; i < CHECK_RING_DEPTH; i++)
+        {
+            PushWork(ring, pool, Work(&groups[i]));
+        }
+        std::thread producer([&]() { PushWork(ring, pool, Work(&groups[CHECK_RING_DEPTH])); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring.close();
+        producer.join();
+        Expect(groups[CHECK_RING_DEPTH].refs.load() == 0, "close() releases a blocked push");
+        //the queued works can still be drained
+        bpu_work work;
+        int drained = 0;
+        while (ring.pop(work))
+        {
+            drained++;
+        }
+        Expect(drained == CHECK_RING_DEPTH, "queued works are popped after close()");
+        Expect(ring.push(Work(&groups[0])) == RingPushResult::kClosed, "push() fails after close()");
+    }
+}
+
+int main()
+{
+    //a lost wakeup hangs instead of failing,turn it into a failure
+    std::thread([]() {
+        std::this_thread::sleep_for(std::chrono::seconds(CHECK_TIMEOUT_SEC));
+        printf("failed:timed out after %d s,a thread is still blocked\n", CHECK_TIMEOUT_SEC);
+        _Exit(1);
+    }).detach();
+
+    CheckPolicy("block", RingOverflowPolicy::kBlock);
+    CheckPolicy("drop_oldest", RingOverflowPolicy::kDropOldest);
+    CheckPolicy("drop_newest", RingOverflowPolicy::kDropNewest);
+    CheckClose();
+    printf("ring check:%d failures\n", failures);
+    return failures ? 1 : 0;
+}
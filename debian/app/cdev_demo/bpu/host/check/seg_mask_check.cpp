@@ -0,0 +1,215 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host check of the yolov5 seg masks,yolov5_seg_BuildMasks
+ *               (roi gemv,then upsample) against a naive full frame
+ *               coefficient x prototype product upsampled the same way,
+ *               for NHWC and NCHW,float and SCALE quantized prototypes.
+ *               make host_check,exits 1 on a failure.
+ ***************************************************************************/
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "yolov5_seg_post_process.hpp"
+
+#define CHECK_PROTO_SIZE (160) //prototype masks of the 640x640 model
+#define CHECK_MODEL_SIZE (640)
+#define CHECK_DETECTIONS (40)
+#define CHECK_ALIGN_PAD (8) //aligned w of the tensor,so the steps are not the valid shape
+#define CHECK_SIGN_EPSILON (1e-3) //logits this close to 0 may flip with the summation order
+
+static int failures = 0;
+
+/**
+ * Prototype tensor with its own storage,values[c][y][x] is what the tensor
+ * holds after dequantization.
+ */
+struct CheckProto
+{
+    hbDNNTensor tensor;
+    std::vector<float> f32;
+    std::vector<int16_t> s16;
+    std::vector<float> scale;
+    std::vector<double> values;
+
+    CheckProto(std::mt19937 &rng, bool nchw, bool quantized)
+    {
+        const int c_num = yolov5_seg_mask_dim_;
+        const int h_num = CHECK_PROTO_SIZE;
+        const int w_num = CHECK_PROTO_SIZE;
+        tensor = hbDNNTensor();
+        hbDNNTensorProperties &properties = tensor.properties;
+        properties.tensorLayout = nchw ? HB_DNN_LAYOUT_NCHW : HB_DNN_LAYOUT_NHWC;
+        properties.tensorType = quantized ? HB_DNN_TENSOR_TYPE_S16 : HB_DNN_TENSOR_TYPE_F32;
+        properties.quantiType = quantized ? SCALE : NONE;
+        int valid[4] = {1, nchw ? c_num : h_num, nchw ? h_num : w_num, nchw ? w_num : c_num};
+        int aligned[4] = {1, valid[1], nchw ? valid[2] : valid[2] + CHECK_ALIGN_PAD, nchw ? valid[3] + CHECK_ALIGN_PAD : valid[3]};
+        properties.validShape.numDimensions = 4;
+        properties.alignedShape.numDimensions = 4;
+        for (int i = 0; i < 4; i++)
+        {
+            properties.validShape.dimensionSize[i] = valid[i];
+            properties.alignedShape.dimensionSize[i] = aligned[i];
+        }
+        size_t elements = (size_t)aligned[1] * aligned[2] * aligned[3];
+        std::uniform_real_distribution<float> value(-1, 1);
+        std::uniform_int_distribution<int> raw(-2000, 2000);
+        values.resize((size_t)c_num * h_num * w_num);
+        if (quantized)
+        {
+            s16.assign(elements, 0);
+            for (int c = 0; c < c_num; c++)
+            {
+                scale.push_back(0.0005f * (1 + c % 5));
+            }
+            properties.scale.scaleLen = c_num;
+            properties.scale.scaleData = scale.data();
+            properties.quantizeAxis = nchw ? 1 : 3;
+            tensor.sysMem[0].virAddr = s16.data();
+        }
+        else
+        {
+            f32.assign(elements, 0);
+            tensor.sysMem[0].virAddr = f32.data();
+        }
+        for (int c = 0; c < c_num; c++)
+        {
+            for (int y = 0; y < h_num; y++)
+            {
+                for (int x = 0; x < w_num; x++)
+                {
+                    size_t at = nchw ? ((size_t)c * aligned[2] + y) * aligned[3] + x
+                                     : ((size_t)y * aligned[2] + x) * aligned[3] + c;
+                    double &v = values[((size_t)c * h_num + y) * w_num + x];
+                    if (quantized)
+                    {
+                        s16[at] = raw(rng);
+                        v = (double)s16[at] * scale[c];
+                    }
+                    else
+                    {
+                        f32[at] = value(rng);
+                        v = f32[at];
+                    }
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Full frame logits of one detection,then the display pixels of its mask
+ * with plain bilinear taps clamped to the prototype.
+ * @return pixels whose sign differs from BuildMasks
+ */
+static int CompareMask(const CheckProto &proto, const float *coefficients, const CoordMapping &mapping,
+                       const InstanceMask &mask, const uint8_t *pixels)
+{
+    const int size = CHECK_PROTO_SIZE;
+    std::vector<double> logits((size_t)size * size, 0.0);
+    for (int c = 0; c < yolov5_seg_mask_dim_; c++)
+    {
+        const double *plane = proto.values.data() + (size_t)c * size * size;
+        for (int k = 0; k < size * size; k++)
+        {
+            logits[k] += coefficients[c] * plane[k];
+        }
+    }
+    double to_proto_x = size / (CHECK_MODEL_SIZE * (double)mapping.scale_x);
+    double to_proto_y = size / (CHECK_MODEL_SIZE * (double)mapping.scale_y);
+    int mismatches = 0;
+    for (int j = 0; j < mask.height; j++)
+    {
+        double py = (mask.y + j + 0.5 - mapping.offset_y) * to_proto_y - 0.5;
+        py = std::min(std::max(py, 0.0), size - 1.0);
+        int y0 = std::min((int)py, size - 2);
+        double wy = py - y0;
+        for (int i = 0; i < mask.width; i++)
+        {
+            double px = (mask.x + i + 0.5 - mapping.offset_x) * to_proto_x - 0.5;
+            px = std::min(std::max(px, 0.0), size - 1.0);
+            int x0 = std::min((int)px, size - 2);
+            double wx = px - x0;
+            const double *top = logits.data() + (size_t)y0 * size + x0;
+            const double *bottom = top + size;
+            double upper = top[0] + (top[1] - top[0]) * wx;
+            double lower = bottom[0] + (bottom[1] - bottom[0]) * wx;
+            double value = upper + (lower - upper) * wy;
+            if (fabs(value) < CHECK_SIGN_EPSILON)
+                continue;
+            mismatches += (value > 0) != (pixels[(size_t)j * mask.width + i] != 0);
+        }
+    }
+    return mismatches;
+}
+
+static void CheckMasks(const char *name, std::mt19937 &rng, const CheckProto &proto, const bpu_image_info_t &image_info,
+                       const InputGeometry &geometry)
+{
+    CoordMapping mapping = CoordMapping::Build(geometry);
+    InstanceSegmentation results;
+    results.detections.Reserve(CHECK_DETECTIONS, yolov5_seg_mask_dim_);
+    std::uniform_real_distribution<float> unit(0, 1), coefficient(-1, 1);
+    float display_w = image_info.m_ori_width, display_h = image_info.m_ori_height;
+    for (int i = 0; i < CHECK_DETECTIONS; i++)
+    {
+        //display boxes as Apply() leaves them,some tiny,some on the display edges
+        float w = i % 8 ? unit(rng) * display_w / 2 : unit(rng) * 3;
+        float h = i % 8 ? unit(rng) * display_h / 2 : unit(rng) * 3;
+        float x = i % 5 ? unit(rng) * (display_w - 1 - w) : (i % 2 ? 0 : display_w - 1 - w);
+        float y = i % 7 ? unit(rng) * (display_h - 1 - h) : (i % 2 ? display_h - 1 - h : 0);
+        int k = results.detections.Push(0, x, y, x + w, y + h, 1.0f);
+        float *extra = results.detections.Extra(k);
+        for (int c = 0; c < yolov5_seg_mask_dim_; c++)
+        {
+            extra[c] = coefficient(rng);
+        }
+    }
+    if (yolov5_seg_BuildMasks(&proto.tensor, image_info, mapping, results) != 0 ||
+        (int)results.masks.size() != CHECK_DETECTIONS)
+    {
+        printf("failed:%s:BuildMasks\n", name);
+        failures++;
+        return;
+    }
+    long pixels = 0;
+    int mismatches = 0;
+    for (int i = 0; i < CHECK_DETECTIONS; i++)
+    {
+        const InstanceMask &mask = results.masks[i];
+        pixels += (long)mask.width * mask.height;
+        mismatches += CompareMask(proto, results.detections.Extra(i), mapping, mask, results.pixels.data() + mask.offset);
+    }
+    printf("%s:%ld mask pixels,%d mismatches\n", name, pixels, mismatches);
+    if (mismatches)
+        failures++;
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    bpu_image_info_t display = {CHECK_MODEL_SIZE, CHECK_MODEL_SIZE, 1920, 1080};
+    bpu_image_info_t headless = {CHECK_MODEL_SIZE, CHECK_MODEL_SIZE, CHECK_MODEL_SIZE, CHECK_MODEL_SIZE};
+    const struct
+    {
+        const char *name;
+        bool nchw;
+        bool quantized;
+    } layouts[] = {{"nhwc f32", false, false}, {"nchw f32", true, false}, {"nhwc s16", false, true}, {"nchw s16", true, true}};
+    for (const auto &layout : layouts)
+    {
+        CheckProto proto(rng, layout.nchw, layout.quantized);
+        char name[64];
+        snprintf(name, sizeof(name), "%s stretch", layout.name);
+        CheckMasks(name, rng, proto, display, InputGeometry::Stretch(display));
+        snprintf(name, sizeof(name), "%s letterbox", layout.name);
+        CheckMasks(name, rng, proto, display, InputGeometry::Letterbox(display, 1920, 1080));
+        snprintf(name, sizeof(name), "%s headless", layout.name);
+        CheckMasks(name, rng, proto, headless, InputGeometry::Letterbox(headless, 1920, 1080));
+    }
+    printf("seg mask check:%d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the board dnn/hb_dnn.h,only what the bpu
+ *               sample uses,see host/src/host_bpu.cpp
+ ***************************************************************************/
+#ifndef DNN_HB_DNN_H_
+#define DNN_HB_DNN_H_
+
+#include <stdint.h>
+#include "hb_sys.h"
+
+#define HB_DNN_TENSOR_MAX_DIMENSIONS 8
+
+typedef void *hbPackedDNNHandle_t;
+typedef void *hbDNNHandle_t;
+typedef void *hbDNNTaskHandle_t;
+
+typedef enum
+{
+    HB_DNN_LAYOUT_NHWC = 0,
+    HB_DNN_LAYOUT_NCHW = 2,
+    HB_DNN_LAYOUT_NONE = 255,
+} hbDNNTensorLayout;
+
+typedef enum
+{
+    HB_DNN_IMG_TYPE_Y,
+    HB_DNN_IMG_TYPE_NV12,
+    HB_DNN_IMG_TYPE_NV12_SEPARATE,
+    HB_DNN_IMG_TYPE_YUV444,
+    HB_DNN_IMG_TYPE_RGB,
+    HB_DNN_IMG_TYPE_BGR,
+    HB_DNN_TENSOR_TYPE_S4,
+    HB_DNN_TENSOR_TYPE_U4,
+    HB_DNN_TENSOR_TYPE_S8,
+    HB_DNN_TENSOR_TYPE_U8,
+    HB_DNN_TENSOR_TYPE_F16,
+    HB_DNN_TENSOR_TYPE_S16,
+    HB_DNN_TENSOR_TYPE_U16,
+    HB_DNN_TENSOR_TYPE_F32,
+    HB_DNN_TENSOR_TYPE_S32,
+    HB_DNN_TENSOR_TYPE_U32,
+    HB_DNN_TENSOR_TYPE_F64,
+    HB_DNN_TENSOR_TYPE_S64,
+    HB_DNN_TENSOR_TYPE_U64,
+    HB_DNN_TENSOR_TYPE_MAX
+} hbDNNDataType;
+
+typedef struct
+{
+    int32_t dimensionSize[HB_DNN_TENSOR_MAX_DIMENSIONS];
+    int32_t numDimensions;
+} hbDNNTensorShape;
+
+typedef struct
+{
+    int32_t shiftLen;
+    uint8_t *shiftData;
+} hbDNNQuantiShift;
+
+typedef struct
+{
+    int32_t scaleLen;
+    float *scaleData;
+    int32_t zeroPointLen;
+    int8_t *zeroPointData;
+} hbDNNQuantiScale;
+
+typedef enum
+{
+    NONE,
+    SHIFT,
+    SCALE,
+} hbDNNQuantiType;
+
+typedef struct
+{
+    hbDNNTensorShape validShape;
+    hbDNNTensorShape alignedShape;
+    int32_t tensorLayout;
+    int32_t tensorType;
+    hbDNNQuantiShift shift;
+    hbDNNQuantiScale scale;
+    hbDNNQuantiType quantiType;
+    int32_t quantizeAxis;
+    int32_t alignedByteSize;
+    int32_t stride[HB_DNN_TENSOR_MAX_DIMENSIONS];
+} hbDNNTensorProperties;
+
+typedef struct
+{
+    hbSysMem sysMem[4];
+    hbDNNTensorProperties properties;
+} hbDNNTensor;
+
+typedef struct
+{
+    int32_t bpuCoreId;
+    int32_t dspCoreId;
+    int32_t priority;
+    int32_t more;
+    int64_t customId;
+    int32_t reserved1;
+    int32_t reserved2;
+} hbDNNInferCtrlParam;
+
+#define HB_DNN_INITIALIZE_INFER_CTRL_PARAM(param) \
+    {                                             \
+        (param)->bpuCoreId = 0;                   \
+        (param)->dspCoreId = 0;                   \
+        (param)->priority = 0;                    \
+        (param)->more = 0;                        \
+        (param)->customId = 0;                    \
+        (param)->reserved1 = 0;                   \
+        (param)->reserved2 = 0;                   \
+    }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t hbDNNGetInputCount(int32_t *inputCount, hbDNNHandle_t dnnHandle);
+int32_t hbDNNGetOutputCount(int32_t *outputCount, hbDNNHandle_t dnnHandle);
+int32_t hbDNNGetInputTensorProperties(hbDNNTensorProperties *properties, hbDNNHandle_t dnnHandle, int32_t inputIndex);
+int32_t hbDNNGetOutputTensorProperties(hbDNNTensorProperties *properties, hbDNNHandle_t dnnHandle, int32_t outputIndex);
+int32_t hbDNNInfer(hbDNNTaskHandle_t *taskHandle, hbDNNTensor **output, hbDNNTensor const *input,
+                   hbDNNHandle_t dnnHandle, hbDNNInferCtrlParam *inferCtrlParam);
+int32_t hbDNNWaitTaskDone(hbDNNTaskHandle_t taskHandle, int32_t timeout);
+int32_t hbDNNReleaseTask(hbDNNTaskHandle_t taskHandle);
+const char *hbDNNGetErrorDesc(int32_t errorCode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DNN_HB_DNN_H_
@@ -0,0 +1,39 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the board dnn/hb_sys.h,only what the bpu
+ *               sample uses,see host/src/host_bpu.cpp
+ ***************************************************************************/
+#ifndef DNN_HB_SYS_H_
+#define DNN_HB_SYS_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint64_t phyAddr;
+    void *virAddr;
+    uint32_t memSize;
+} hbSysMem;
+
+typedef enum
+{
+    HB_SYS_MEM_CACHE_INVALIDATE = 1,
+    HB_SYS_MEM_CACHE_CLEAN = 2
+} hbSysMemFlushFlag;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t hbSysAllocMem(hbSysMem *mem, uint32_t size);
+int32_t hbSysAllocCachedMem(hbSysMem *mem, uint32_t size);
+int32_t hbSysFlushMem(hbSysMem *mem, int32_t flag);
+int32_t hbSysFreeMem(hbSysMem *mem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DNN_HB_SYS_H_
@@ -0,0 +1,45 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the libspcdev sp_bpu.h,the model file is a
+ *               host model spec,see host/models
+ ***************************************************************************/
+#ifndef SP_BPU_H_
+#define SP_BPU_H_
+
+#include <dnn/hb_dnn.h>
+#include <dnn/hb_sys.h>
+
+typedef struct
+{
+    hbPackedDNNHandle_t m_packed_dnn_handle;
+    hbDNNHandle_t m_dnn_handle;
+    hbDNNTensor m_input_tensor;
+    hbDNNTensor *output_tensor;
+    hbDNNTaskHandle_t m_task_handle;
+} bpu_module;
+
+typedef struct
+{
+    int32_t m_model_w;
+    int32_t m_model_h;
+    int32_t m_ori_width;
+    int32_t m_ori_height;
+} bpu_image_info_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bpu_module *sp_init_bpu_module(const char *model_file_name);
+int32_t sp_init_bpu_tensors(bpu_module *bpu_handle, hbDNNTensor *output_tensors);
+int32_t sp_deinit_bpu_tensor(hbDNNTensor *tensor, int32_t len);
+int32_t sp_bpu_start_predict(bpu_module *bpu_handle, char *addr);
+int32_t sp_release_bpu_module(bpu_module *bpu_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SP_BPU_H_
@@ -0,0 +1,31 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the libspcdev sp_codec.h,the decoder only
+ *               feeds the synthetic vps frames
+ ***************************************************************************/
+#ifndef SP_CODEC_H_
+#define SP_CODEC_H_
+
+#include <stdint.h>
+
+#define SP_ENCODER_H264 1
+#define SP_ENCODER_H265 2
+#define SP_ENCODER_MJPEG 3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *sp_init_decoder_module();
+void sp_release_decoder_module(void *obj);
+int32_t sp_start_decode(void *decoder_obj, const char *stream_file, int32_t video_chn, int32_t type,
+                        int32_t width, int32_t height);
+int32_t sp_stop_decode(void *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SP_CODEC_H_
@@ -0,0 +1,28 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the libspcdev sp_sys.h
+ ***************************************************************************/
+#ifndef SP_SYS_H_
+#define SP_SYS_H_
+
+#include <stdint.h>
+
+#define SP_MTYPE_VIO 0x1001
+#define SP_MTYPE_ENCODER 0x1002
+#define SP_MTYPE_DECODER 0x1003
+#define SP_MTYPE_DISPLAY 0x1004
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t sp_module_bind(void *src, int32_t src_type, void *dst, int32_t dst_type);
+int32_t sp_module_unbind(void *src, int32_t src_type, void *dst, int32_t dst_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SP_SYS_H_
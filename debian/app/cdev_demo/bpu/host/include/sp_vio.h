@@ -0,0 +1,37 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the libspcdev sp_vio.h,the camera and the
+ *               vps produce synthetic nv12 frames
+ ***************************************************************************/
+#ifndef SP_VIO_H_
+#define SP_VIO_H_
+
+#include <stdint.h>
+
+#define SP_VPS_SCALE 1
+#define SP_VPS_CROP 2
+#define SP_VPS_ROTATE 3
+
+#define FRAME_BUFFER_SIZE(w, h) ((w) * (h) * 3 / 2)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *sp_init_vio_module();
+void sp_release_vio_module(void *obj);
+int32_t sp_open_camera(void *obj, const int32_t pipe_id, const int32_t video_index, int32_t chn_num,
+                       int32_t *width, int32_t *height);
+int32_t sp_open_vps(void *obj, const int32_t pipe_id, int32_t chn_num, int32_t proc_mode,
+                    int32_t src_width, int32_t src_height, int32_t *dst_width, int32_t *dst_height,
+                    int32_t *crop_x, int32_t *crop_y, int32_t *crop_width, int32_t *crop_height, int32_t *rotate);
+int32_t sp_vio_close(void *obj);
+int32_t sp_vio_get_frame(void *obj, char *frame_buffer, int32_t width, int32_t height, const int32_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SP_VIO_H_
@@ -0,0 +1,11 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the board vio/hb_common_vot.h,the bpu
+ *               sample uses nothing from it
+ ***************************************************************************/
+#ifndef HB_COMMON_VOT_H_
+#define HB_COMMON_VOT_H_
+
+#endif // HB_COMMON_VOT_H_
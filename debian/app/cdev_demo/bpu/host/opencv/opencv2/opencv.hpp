@@ -0,0 +1,119 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: minimal opencv stand-in for host builds without opencv,
+ *               only the 8 bit Mat wrapper and the bilinear resize the bpu
+ *               sample uses. The Makefile picks the real opencv when
+ *               pkg-config finds it.
+ ***************************************************************************/
+#ifndef HOST_OPENCV_HPP_
+#define HOST_OPENCV_HPP_
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+//the real opencv pulls these in and the post processors rely on it
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace cv
+{
+enum
+{
+    CV_8UC1 = 0,
+    CV_8UC2 = 8,
+    CV_8UC3 = 16,
+};
+
+enum
+{
+    INTER_NEAREST = 0,
+    INTER_LINEAR = 1,
+};
+
+struct Size
+{
+    Size(int width_, int height_) : width(width_), height(height_) {}
+    int width;
+    int height;
+};
+
+/**
+ * Non owning view of a continuous 8 bit image,or owning when no data is given.
+ */
+class Mat
+{
+public:
+    Mat() {}
+    Mat(int rows_, int cols_, int type, void *data_ = nullptr)
+        : rows(rows_), cols(cols_), channels_(type / 8 + 1)
+    {
+        if (!data_)
+        {
+            owned_.resize((size_t)rows * cols * channels_);
+            data_ = owned_.data();
+        }
+        data = static_cast<unsigned char *>(data_);
+    }
+    Mat(const Mat &other) = delete; //views only,copying would alias owned_
+    Mat &operator=(const Mat &other) = delete;
+
+    int channels() const { return channels_; }
+    size_t total() const { return (size_t)rows * cols; }
+
+    int rows = 0;
+    int cols = 0;
+    unsigned char *data = nullptr;
+
+private:
+    int channels_ = 1;
+    std::vector<unsigned char> owned_;
+};
+
+/**
+ * Bilinear resize with opencv's half pixel centers,dst must already have
+ * the target size and the channel count of src.
+ */
+inline void resize(const Mat &src, Mat &dst, Size size, double fx = 0, double fy = 0, int interpolation = INTER_LINEAR)
+{
+    const int channels = src.channels();
+    const float scale_x = (float)src.cols / size.width;
+    const float scale_y = (float)src.rows / size.height;
+    for (int y = 0; y < size.height; y++)
+    {
+        float sy = std::max((y + 0.5f) * scale_y - 0.5f, 0.0f);
+        int y0 = std::min((int)sy, src.rows - 1);
+        int y1 = std::min(y0 + 1, src.rows - 1);
+        float wy = interpolation == INTER_NEAREST ? 0 : sy - y0;
+        const unsigned char *row0 = src.data + (size_t)y0 * src.cols * channels;
+        const unsigned char *row1 = src.data + (size_t)y1 * src.cols * channels;
+        unsigned char *out = dst.data + (size_t)y * size.width * channels;
+        for (int x = 0; x < size.width; x++)
+        {
+            float sx = std::max((x + 0.5f) * scale_x - 0.5f, 0.0f);
+            int x0 = std::min((int)sx, src.cols - 1);
+            int x1 = std::min(x0 + 1, src.cols - 1);
+            float wx = interpolation == INTER_NEAREST ? 0 : sx - x0;
+            for (int c = 0; c < channels; c++)
+            {
+                float top = row0[x0 * channels + c] + (row0[x1 * channels + c] - row0[x0 * channels + c]) * wx;
+                float bottom = row1[x0 * channels + c] + (row1[x1 * channels + c] - row1[x0 * channels + c]) * wx;
+                out[x * channels + c] = (unsigned char)(top + (bottom - top) * wy + 0.5f);
+            }
+        }
+    }
+}
+} // namespace cv
+
+using cv::CV_8UC1;
+using cv::CV_8UC2;
+using cv::CV_8UC3;
+
+#endif // HOST_OPENCV_HPP_
@@ -0,0 +1,570 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of libdnn and the sp_bpu part of libspcdev.
+ *               The "model file" is a text spec of the board model outputs,
+ *               inference copies recorded or synthetic tensors into them
+ *               after a simulated bpu latency. See host/models.
+ ***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sp_bpu.h"
+#include "sp_vio.h"
+
+#define HOST_SYNTHETIC_FRAMES 4 //distinct synthetic output sets,replayed in turn
+
+enum
+{
+    HOST_DNN_OK = 0,
+    HOST_DNN_INVALID_ARGUMENT = -6000001,
+    HOST_DNN_TIMEOUT = -6000002,
+};
+
+typedef std::chrono::steady_clock HostClock;
+
+struct HostOutput
+{
+    hbDNNTensorProperties properties;
+    std::vector<float> scale; //properties.scale.scaleData
+};
+
+/**
+ * Everything parsed from the spec,plus the simulated bpu cores.
+ */
+struct HostModel
+{
+    int input_w = 0;
+    int input_h = 0;
+    std::vector<HostOutput> outputs;
+    std::chrono::microseconds latency{0};
+    std::vector<HostClock::time_point> cores{1}; //time each core becomes free
+    //frames[i][j]:output j of recorded or synthetic frame i,aligned byte size
+    std::vector<std::vector<std::vector<char>>> frames;
+    size_t next_frame = 0;
+    std::mutex mtx;
+};
+
+struct HostTask
+{
+    HostModel *model;
+    hbDNNTensor *outputs;
+    size_t frame;
+    HostClock::time_point deadline;
+    bool done;
+};
+
+static int ElementSize(int type)
+{
+    switch (type)
+    {
+    case HB_DNN_TENSOR_TYPE_S8:
+    case HB_DNN_TENSOR_TYPE_U8:
+        return 1;
+    case HB_DNN_TENSOR_TYPE_S16:
+    case HB_DNN_TENSOR_TYPE_U16:
+    case HB_DNN_TENSOR_TYPE_F16:
+        return 2;
+    case HB_DNN_TENSOR_TYPE_F64:
+    case HB_DNN_TENSOR_TYPE_S64:
+    case HB_DNN_TENSOR_TYPE_U64:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+static bool ParseType(const std::string &name, int &type)
+{
+    static const struct
+    {
+        const char *name;
+        int type;
+    } types[] = {{"f32", HB_DNN_TENSOR_TYPE_F32}, {"s32", HB_DNN_TENSOR_TYPE_S32},
+                 {"s16", HB_DNN_TENSOR_TYPE_S16}, {"s8", HB_DNN_TENSOR_TYPE_S8}};
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        if (name == types[i].name)
+        {
+            type = types[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void SetShape(hbDNNTensorShape &shape, const int dims[4])
+{
+    memset(&shape, 0, sizeof(shape));
+    shape.numDimensions = 4;
+    for (int i = 0; i < 4; i++)
+    {
+        shape.dimensionSize[i] = dims[i];
+    }
+}
+
+static void FinishProperties(hbDNNTensorProperties &properties)
+{
+    int element = ElementSize(properties.tensorType);
+    properties.stride[3] = element;
+    for (int i = 2; i >= 0; i--)
+    {
+        properties.stride[i] = properties.stride[i + 1] * properties.alignedShape.dimensionSize[i + 1];
+    }
+    properties.alignedByteSize = properties.stride[0] * properties.alignedShape.dimensionSize[0];
+}
+
+/**
+ * output <f32|s32|s16|s8> <nhwc|nchw> n h w c|n c h w [scale s] [aligned d0 d1 d2 d3]
+ */
+static bool ParseOutput(std::istringstream &line, HostOutput &output)
+{
+    std::string type, layout;
+    int dims[4];
+    line >> type >> layout >> dims[0] >> dims[1] >> dims[2] >> dims[3];
+    hbDNNTensorProperties &properties = output.properties;
+    memset(&properties, 0, sizeof(properties));
+    if (!line || !ParseType(type, properties.tensorType) || (layout != "nhwc" && layout != "nchw"))
+        return false;
+    properties.tensorLayout = layout == "nhwc" ? HB_DNN_LAYOUT_NHWC : HB_DNN_LAYOUT_NCHW;
+    properties.quantizeAxis = layout == "nhwc" ? 3 : 1;
+    properties.quantiType = NONE;
+    SetShape(properties.validShape, dims);
+    SetShape(properties.alignedShape, dims);
+    std::string key;
+    while (line >> key)
+    {
+        if (key == "scale")
+        {
+            float scale = 0;
+            if (!(line >> scale))
+                return false;
+            properties.quantiType = SCALE;
+            output.scale.assign(dims[properties.quantizeAxis], scale);
+        }
+        else if (key == "aligned")
+        {
+            int aligned[4];
+            if (!(line >> aligned[0] >> aligned[1] >> aligned[2] >> aligned[3]))
+                return false;
+            SetShape(properties.alignedShape, aligned);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    FinishProperties(properties);
+    return true;
+}
+
+/**
+ * Fill one frame with values uniform in [low, high],hot_ratio of them in
+ * [hot_low, hot_high],quantized with the output scale when there is one.
+ */
+static void Synthesize(HostModel &model, std::mt19937 &rng, float low, float high, float hot_ratio,
+                       float hot_low, float hot_high)
+{
+    std::uniform_real_distribution<float> cold(low, high), hot(hot_low, hot_high), pick(0, 1);
+    std::vector<std::vector<char>> frame;
+    for (size_t i = 0; i < model.outputs.size(); i++)
+    {
+        const hbDNNTensorProperties &properties = model.outputs[i].properties;
+        float scale = model.outputs[i].scale.empty() ? 1 : model.outputs[i].scale[0];
+        int element = ElementSize(properties.tensorType);
+        std::vector<char> data(properties.alignedByteSize);
+        for (size_t offset = 0; offset + element <= data.size(); offset += element)
+        {
+            float value = pick(rng) < hot_ratio ? hot(rng) : cold(rng);
+            char *out = data.data() + offset;
+            switch (properties.tensorType)
+            {
+            case HB_DNN_TENSOR_TYPE_S32:
+                *reinterpret_cast<int32_t *>(out) = (int32_t)lroundf(value / scale);
+                break;
+            case HB_DNN_TENSOR_TYPE_S16:
+                *reinterpret_cast<int16_t *>(out) = (int16_t)std::max(-32768.0f, std::min(32767.0f, roundf(value / scale)));
+                break;
+            case HB_DNN_TENSOR_TYPE_S8:
+                *reinterpret_cast<int8_t *>(out) = (int8_t)std::max(-128.0f, std::min(127.0f, roundf(value / scale)));
+                break;
+            default:
+                *reinterpret_cast<float *>(out) = value;
+                break;
+            }
+        }
+        frame.push_back(std::move(data));
+    }
+    model.frames.push_back(std::move(frame));
+}
+
+/**
+ * Load dir/<frame>_<output>.bin,frame counting from 0,until a frame is missing.
+ */
+static bool LoadRecord(HostModel &model, const std::string &dir)
+{
+    for (int i = 0;; i++)
+    {
+        std::vector<std::vector<char>> frame;
+        for (size_t j = 0; j < model.outputs.size(); j++)
+        {
+            std::string file = dir + "/" + std::to_string(i) + "_" + std::to_string(j) + ".bin";
+            std::ifstream in(file, std::ios::binary);
+            if (!in)
+            {
+                if (j == 0 && i > 0)
+                    return true;
+                printf("host bpu:missing recorded tensor %s\n", file.c_str());
+                return false;
+            }
+            std::vector<char> data(model.outputs[j].properties.alignedByteSize);
+            in.read(data.data(), data.size());
+            if ((size_t)in.gcount() != data.size())
+            {
+                printf("host bpu:%s holds %ld bytes,expect %zu\n", file.c_str(), (long)in.gcount(), data.size());
+                return false;
+            }
+            frame.push_back(std::move(data));
+        }
+        model.frames.push_back(std::move(frame));
+    }
+}
+
+/**
+ * Spec lines,# starts a comment:
+ *   input w h
+ *   output ...            one per model output,in output order,see ParseOutput
+ *   latency_us n          simulated time of one inference,default 0
+ *   cores n               inferences the bpu runs at the same time,default 1
+ *   synthetic seed low high [hot_ratio hot_low hot_high]
+ *   record dir            replay recorded tensors instead of synthetic ones,
+ *                         a relative dir is relative to the spec
+ */
+static HostModel *LoadModel(const char *path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        printf("host bpu:open model spec %s failed\n", path);
+        return nullptr;
+    }
+    std::unique_ptr<HostModel> model(new HostModel);
+    std::string text, record;
+    unsigned seed = 1;
+    float low = -8, high = 0, hot_ratio = 0, hot_low = 0, hot_high = 0;
+    for (int number = 1; std::getline(in, text); number++)
+    {
+        text = text.substr(0, text.find('#'));
+        std::istringstream line(text);
+        std::string key;
+        if (!(line >> key))
+            continue;
+        bool ok = true;
+        if (key == "input")
+        {
+            ok = !!(line >> model->input_w >> model->input_h);
+        }
+        else if (key == "output")
+        {
+            HostOutput output;
+            ok = ParseOutput(line, output);
+            model->outputs.push_back(output);
+        }
+        else if (key == "latency_us")
+        {
+            long us = 0;
+            ok = !!(line >> us);
+            model->latency = std::chrono::microseconds(us);
+        }
+        else if (key == "cores")
+        {
+            int cores = 0;
+            ok = !!(line >> cores) && cores > 0;
+            model->cores.resize(std::max(cores, 1));
+        }
+        else if (key == "synthetic")
+        {
+            ok = !!(line >> seed >> low >> high);
+            if (ok && !(line >> hot_ratio >> hot_low >> hot_high))
+                hot_ratio = 0;
+        }
+        else if (key == "record")
+        {
+            ok = !!(line >> record);
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            printf("host bpu:%s:%d:bad line:%s\n", path, number, text.c_str());
+            return nullptr;
+        }
+    }
+    if (model->input_w <= 0 || model->input_h <= 0 || model->outputs.empty())
+    {
+        printf("host bpu:%s needs an input and at least one output\n", path);
+        return nullptr;
+    }
+    //the scale vectors are final now,point the properties at them
+    for (size_t i = 0; i < model->outputs.size(); i++)
+    {
+        HostOutput &output = model->outputs[i];
+        output.properties.scale.scaleLen = output.scale.size();
+        output.properties.scale.scaleData = output.scale.empty() ? nullptr : output.scale.data();
+    }
+    if (!record.empty())
+    {
+        std::string spec(path);
+        if (record[0] != '/' && spec.find('/') != std::string::npos)
+            record = spec.substr(0, spec.rfind('/') + 1) + record; //relative to the spec
+        if (!LoadRecord(*model, record))
+            return nullptr;
+    }
+    else
+    {
+        std::mt19937 rng(seed);
+        for (int i = 0; i < HOST_SYNTHETIC_FRAMES; i++)
+        {
+            Synthesize(*model, rng, low, high, hot_ratio, hot_low, hot_high);
+        }
+    }
+    printf("host bpu:%s,%dx%d input,%zu outputs,%zu %s frames,%ld us per inference\n", path,
+           model->input_w, model->input_h, model->outputs.size(), model->frames.size(),
+           record.empty() ? "synthetic" : "recorded", (long)model->latency.count());
+    return model.release();
+}
+
+extern "C" {
+
+int32_t hbSysAllocMem(hbSysMem *mem, uint32_t size)
+{
+    return hbSysAllocCachedMem(mem, size);
+}
+
+int32_t hbSysAllocCachedMem(hbSysMem *mem, uint32_t size)
+{
+    if (!mem)
+        return HOST_DNN_INVALID_ARGUMENT;
+    void *addr = nullptr;
+    if (posix_memalign(&addr, 64, std::max<uint32_t>(size, 1)))
+        return HOST_DNN_INVALID_ARGUMENT;
+    memset(addr, 0, size);
+    mem->virAddr = addr;
+    mem->phyAddr = reinterpret_cast<uintptr_t>(addr);
+    mem->memSize = size;
+    return HOST_DNN_OK;
+}
+
+int32_t hbSysFlushMem(hbSysMem *mem, int32_t flag)
+{
+    return mem ? HOST_DNN_OK : HOST_DNN_INVALID_ARGUMENT; //host memory is coherent
+}
+
+int32_t hbSysFreeMem(hbSysMem *mem)
+{
+    if (!mem)
+        return HOST_DNN_INVALID_ARGUMENT;
+    free(mem->virAddr);
+    mem->virAddr = nullptr;
+    mem->phyAddr = 0;
+    return HOST_DNN_OK;
+}
+
+int32_t hbDNNGetInputCount(int32_t *inputCount, hbDNNHandle_t dnnHandle)
+{
+    if (!inputCount || !dnnHandle)
+        return HOST_DNN_INVALID_ARGUMENT;
+    *inputCount = 1;
+    return HOST_DNN_OK;
+}
+
+int32_t hbDNNGetOutputCount(int32_t *outputCount, hbDNNHandle_t dnnHandle)
+{
+    if (!outputCount || !dnnHandle)
+        return HOST_DNN_INVALID_ARGUMENT;
+    *outputCount = static_cast<HostModel *>(dnnHandle)->outputs.size();
+    return HOST_DNN_OK;
+}
+
+int32_t hbDNNGetInputTensorProperties(hbDNNTensorProperties *properties, hbDNNHandle_t dnnHandle, int32_t inputIndex)
+{
+    if (!properties || !dnnHandle || inputIndex != 0)
+        return HOST_DNN_INVALID_ARGUMENT;
+    HostModel *model = static_cast<HostModel *>(dnnHandle);
+    int dims[4] = {1, 3, model->input_h, model->input_w};
+    memset(properties, 0, sizeof(*properties));
+    properties->tensorType = HB_DNN_IMG_TYPE_NV12;
+    properties->tensorLayout = HB_DNN_LAYOUT_NCHW;
+    SetShape(properties->validShape, dims);
+    SetShape(properties->alignedShape, dims);
+    properties->alignedByteSize = FRAME_BUFFER_SIZE(model->input_w, model->input_h);
+    return HOST_DNN_OK;
+}
+
+int32_t hbDNNGetOutputTensorProperties(hbDNNTensorProperties *properties, hbDNNHandle_t dnnHandle, int32_t outputIndex)
+{
+    HostModel *model = static_cast<HostModel *>(dnnHandle);
+    if (!properties || !model || outputIndex < 0 || outputIndex >= (int)model->outputs.size())
+        return HOST_DNN_INVALID_ARGUMENT;
+    *properties = model->outputs[outputIndex].properties;
+    return HOST_DNN_OK;
+}
+
+int32_t hbDNNInfer(hbDNNTaskHandle_t *taskHandle, hbDNNTensor **output, hbDNNTensor const *input,
+                   hbDNNHandle_t dnnHandle, hbDNNInferCtrlParam *inferCtrlParam)
+{
+    HostModel *model = static_cast<HostModel *>(dnnHandle);
+    if (!taskHandle || !output || !*output || !input || !model)
+        return HOST_DNN_INVALID_ARGUMENT;
+    HostTask *task = new HostTask;
+    task->model = model;
+    task->outputs = *output;
+    task->done = false;
+    {
+        //queue on the core that frees up first,like the bpu scheduler
+        std::lock_guard<std::mutex> lock(model->mtx);
+        auto core = std::min_element(model->cores.begin(), model->cores.end());
+        *core = std::max(*core, HostClock::now()) + model->latency;
+        task->deadline = *core;
+        task->frame = model->next_frame;
+        model->next_frame = (model->next_frame + 1) % model->frames.size();
+    }
+    *taskHandle = task;
+    return HOST_DNN_OK;
+}
+
+int32_t hbDNNWaitTaskDone(hbDNNTaskHandle_t taskHandle, int32_t timeout)
+{
+    HostTask *task = static_cast<HostTask *>(taskHandle);
+    if (!task)
+        return HOST_DNN_INVALID_ARGUMENT;
+    if (timeout > 0 && task->deadline > HostClock::now() + std::chrono::milliseconds(timeout))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        return HOST_DNN_TIMEOUT;
+    }
+    std::this_thread::sleep_until(task->deadline);
+    if (!task->done)
+    {
+        //outputs show up when the task is done,as they do on the bpu
+        const std::vector<std::vector<char>> &frame = task->model->frames[task->frame];
+        for (size_t i = 0; i < frame.size(); i++)
+        {
+            memcpy(task->outputs[i].sysMem[0].virAddr, frame[i].data(), frame[i].size());
+        }
+        task->done = true;
+    }
+    return HOST_DNN_OK;
+}
+
+int32_t hbDNNReleaseTask(hbDNNTaskHandle_t taskHandle)
+{
+    if (!taskHandle)
+        return HOST_DNN_INVALID_ARGUMENT;
+    delete static_cast<HostTask *>(taskHandle);
+    return HOST_DNN_OK;
+}
+
+const char *hbDNNGetErrorDesc(int32_t errorCode)
+{
+    switch (errorCode)
+    {
+    case HOST_DNN_OK:
+        return "ok";
+    case HOST_DNN_INVALID_ARGUMENT:
+        return "invalid argument";
+    case HOST_DNN_TIMEOUT:
+        return "task timeout";
+    default:
+        return "unknown error";
+    }
+}
+
+bpu_module *sp_init_bpu_module(const char *model_file_name)
+{
+    HostModel *model = LoadModel(model_file_name);
+    if (!model)
+        return nullptr;
+    bpu_module *bpu = new bpu_module;
+    memset(bpu, 0, sizeof(*bpu));
+    bpu->m_packed_dnn_handle = model;
+    bpu->m_dnn_handle = model;
+    hbDNNGetInputTensorProperties(&bpu->m_input_tensor.properties, model, 0);
+    hbSysAllocCachedMem(&bpu->m_input_tensor.sysMem[0], bpu->m_input_tensor.properties.alignedByteSize);
+    return bpu;
+}
+
+int32_t sp_init_bpu_tensors(bpu_module *bpu_handle, hbDNNTensor *output_tensors)
+{
+    if (!bpu_handle || !output_tensors)
+        return HOST_DNN_INVALID_ARGUMENT;
+    HostModel *model = static_cast<HostModel *>(bpu_handle->m_dnn_handle);
+    for (size_t i = 0; i < model->outputs.size(); i++)
+    {
+        hbDNNTensor &tensor = output_tensors[i];
+        memset(&tensor, 0, sizeof(tensor));
+        tensor.properties = model->outputs[i].properties;
+        int ret = hbSysAllocCachedMem(&tensor.sysMem[0], tensor.properties.alignedByteSize);
+        if (ret)
+        {
+            sp_deinit_bpu_tensor(output_tensors, i);
+            return ret;
+        }
+    }
+    bpu_handle->output_tensor = output_tensors;
+    return HOST_DNN_OK;
+}
+
+int32_t sp_deinit_bpu_tensor(hbDNNTensor *tensor, int32_t len)
+{
+    if (!tensor)
+        return HOST_DNN_INVALID_ARGUMENT;
+    for (int i = 0; i < len; i++)
+    {
+        hbSysFreeMem(&tensor[i].sysMem[0]);
+    }
+    return HOST_DNN_OK;
+}
+
+int32_t sp_bpu_start_predict(bpu_module *bpu_handle, char *addr)
+{
+    if (!bpu_handle || !addr || !bpu_handle->output_tensor)
+        return HOST_DNN_INVALID_ARGUMENT;
+    memcpy(bpu_handle->m_input_tensor.sysMem[0].virAddr, addr, bpu_handle->m_input_tensor.properties.alignedByteSize);
+    hbDNNInferCtrlParam infer_ctrl_param;
+    HB_DNN_INITIALIZE_INFER_CTRL_PARAM(&infer_ctrl_param);
+    int ret = hbDNNInfer(&bpu_handle->m_task_handle, &bpu_handle->output_tensor, &bpu_handle->m_input_tensor,
+                         bpu_handle->m_dnn_handle, &infer_ctrl_param);
+    if (ret)
+        return ret;
+    ret = hbDNNWaitTaskDone(bpu_handle->m_task_handle, 0);
+    hbDNNReleaseTask(bpu_handle->m_task_handle);
+    bpu_handle->m_task_handle = nullptr;
+    return ret;
+}
+
+int32_t sp_release_bpu_module(bpu_module *bpu_handle)
+{
+    if (!bpu_handle)
+        return HOST_DNN_INVALID_ARGUMENT;
+    hbSysFreeMem(&bpu_handle->m_input_tensor.sysMem[0]);
+    delete static_cast<HostModel *>(bpu_handle->m_dnn_handle);
+    delete bpu_handle;
+    return HOST_DNN_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,206 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: host stand-in of the vio,display,codec and sys parts of
+ *               libspcdev. The camera and the vps produce a moving synthetic
+ *               nv12 pattern at SP_HOST_CAMERA_FPS (default 30,0 for as fast
+ *               as possible),the display only counts what is drawn.
+ ***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "sp_vio.h"
+#include "sp_display.h"
+#include "sp_codec.h"
+#include "sp_sys.h"
+
+#define HOST_CAMERA_FPS 30
+#define HOST_DISPLAY_WIDTH 1920
+#define HOST_DISPLAY_HEIGHT 1080
+
+typedef std::chrono::steady_clock HostClock;
+
+struct HostVio
+{
+    bool opened;
+    unsigned frame;
+    HostClock::duration interval;
+    HostClock::time_point next_time;
+};
+
+struct HostDisplay
+{
+    unsigned long long rects;
+    unsigned long long strings;
+};
+
+extern "C" {
+
+void *sp_init_vio_module()
+{
+    HostVio *vio = new HostVio;
+    vio->opened = false;
+    vio->frame = 0;
+    const char *fps_env = getenv("SP_HOST_CAMERA_FPS");
+    int fps = fps_env ? atoi(fps_env) : HOST_CAMERA_FPS;
+    vio->interval = fps > 0 ? std::chrono::duration_cast<HostClock::duration>(std::chrono::duration<double>(1.0 / fps))
+                            : HostClock::duration(0);
+    return vio;
+}
+
+void sp_release_vio_module(void *obj)
+{
+    delete static_cast<HostVio *>(obj);
+}
+
+int32_t sp_open_camera(void *obj, const int32_t pipe_id, const int32_t video_index, int32_t chn_num,
+                       int32_t *width, int32_t *height)
+{
+    HostVio *vio = static_cast<HostVio *>(obj);
+    if (!vio || chn_num < 1 || !width || !height)
+        return -1;
+    vio->opened = true;
+    vio->next_time = HostClock::now();
+    printf("host vio:synthetic camera,%d chn,first %dx%d\n", chn_num, width[0], height[0]);
+    return 0;
+}
+
+int32_t sp_open_vps(void *obj, const int32_t pipe_id, int32_t chn_num, int32_t proc_mode,
+                    int32_t src_width, int32_t src_height, int32_t *dst_width, int32_t *dst_height,
+                    int32_t *crop_x, int32_t *crop_y, int32_t *crop_width, int32_t *crop_height, int32_t *rotate)
+{
+    HostVio *vio = static_cast<HostVio *>(obj);
+    if (!vio || chn_num < 1 || !dst_width || !dst_height)
+        return -1;
+    vio->opened = true;
+    vio->next_time = HostClock::now();
+    printf("host vio:synthetic vps,%dx%d -> %dx%d\n", src_width, src_height, dst_width[0], dst_height[0]);
+    return 0;
+}
+
+int32_t sp_vio_close(void *obj)
+{
+    HostVio *vio = static_cast<HostVio *>(obj);
+    if (!vio)
+        return -1;
+    vio->opened = false;
+    return 0;
+}
+
+int32_t sp_vio_get_frame(void *obj, char *frame_buffer, int32_t width, int32_t height, const int32_t timeout)
+{
+    HostVio *vio = static_cast<HostVio *>(obj);
+    if (!vio || !vio->opened || !frame_buffer)
+        return -1;
+    if (vio->interval.count())
+    {
+        std::this_thread::sleep_until(vio->next_time);
+        vio->next_time = std::max(vio->next_time + vio->interval, HostClock::now() - vio->interval);
+    }
+    //diagonal luma ramp moving a few pixels per frame,neutral chroma
+    unsigned char *y = reinterpret_cast<unsigned char *>(frame_buffer);
+    unsigned shift = vio->frame++ * 4;
+    for (int row = 0; row < height; row++)
+    {
+        for (int col = 0; col < width; col++)
+        {
+            y[row * width + col] = (unsigned char)(row + col + shift);
+        }
+    }
+    memset(frame_buffer + width * height, 128, width * height / 2);
+    return 0;
+}
+
+void *sp_init_display_module()
+{
+    HostDisplay *display = new HostDisplay;
+    display->rects = 0;
+    display->strings = 0;
+    return display;
+}
+
+void sp_release_display_module(void *obj)
+{
+    HostDisplay *display = static_cast<HostDisplay *>(obj);
+    if (!display)
+        return;
+    printf("host display:%llu rects,%llu strings drawn\n", display->rects, display->strings);
+    delete display;
+}
+
+int32_t sp_start_display(void *obj, int32_t chn, int32_t width, int32_t height)
+{
+    return obj ? 0 : -1;
+}
+
+int32_t sp_stop_display(void *obj)
+{
+    return obj ? 0 : -1;
+}
+
+int32_t sp_display_draw_rect(void *obj, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                             int32_t chn, int32_t flush, int32_t color, int32_t line_width)
+{
+    HostDisplay *display = static_cast<HostDisplay *>(obj);
+    if (!display)
+        return -1;
+    if (!flush)
+        display->rects++;
+    return 0;
+}
+
+int32_t sp_display_draw_string(void *obj, int32_t x, int32_t y, char *str,
+                               int32_t chn, int32_t flush, int32_t color, int32_t line_width)
+{
+    HostDisplay *display = static_cast<HostDisplay *>(obj);
+    if (!display || !str)
+        return -1;
+    display->strings++;
+    return 0;
+}
+
+void sp_get_display_resolution(int32_t *width, int32_t *height)
+{
+    *width = HOST_DISPLAY_WIDTH;
+    *height = HOST_DISPLAY_HEIGHT;
+}
+
+void *sp_init_decoder_module()
+{
+    return new int(0);
+}
+
+void sp_release_decoder_module(void *obj)
+{
+    delete static_cast<int *>(obj);
+}
+
+int32_t sp_start_decode(void *decoder_obj, const char *stream_file, int32_t video_chn, int32_t type,
+                        int32_t width, int32_t height)
+{
+    if (!decoder_obj)
+        return -1;
+    printf("host decoder:%s is not decoded,the vps bound to it makes synthetic frames\n", stream_file);
+    return 0;
+}
+
+int32_t sp_stop_decode(void *obj)
+{
+    return obj ? 0 : -1;
+}
+
+int32_t sp_module_bind(void *src, int32_t src_type, void *dst, int32_t dst_type)
+{
+    return src && dst ? 0 : -1;
+}
+
+int32_t sp_module_unbind(void *src, int32_t src_type, void *dst, int32_t dst_type)
+{
+    return src && dst ? 0 : -1;
+}
+
+} // extern "C"
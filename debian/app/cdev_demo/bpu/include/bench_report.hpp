@@ -0,0 +1,99 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: headless benchmark bookkeeping and json report
+ ***************************************************************************/
+#ifndef bench_report
+#define bench_report
+
+#include <stdint.h>
+#include <time.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define BENCH_WARMUP_FRAMES 50 //default frames drawn before measuring starts
+#define BENCH_FRAMES 1000 //default frames measured when no duration is given
+
+/**
+ * Cpu time of the pipeline threads. Every thread registers itself once,
+ * Mark() samples all of them from any thread. A thread that exits while
+ * measuring samples itself on the way out,the clock of a joined thread
+ * can not be read anymore.
+ */
+class ThreadCpuTimes
+{
+public:
+    struct Entry
+    {
+        std::string name;
+        clockid_t clock;
+        int64_t start_ns;
+        int64_t end_ns; //0 until measuring ends or the thread exits
+    };
+
+    /**
+     * Held by a registered thread until it exits.
+     */
+    class Registration
+    {
+    public:
+        Registration(Registration &&other) : index_(other.index_) { other.index_ = -1; }
+        ~Registration();
+
+    private:
+        friend class ThreadCpuTimes;
+        explicit Registration(int index) : index_(index) {}
+
+        int index_; //entry of the thread,-1 if not registered
+    };
+
+    static ThreadCpuTimes &Get();
+
+    /**
+     * Register the calling thread,keep the result alive until it exits.
+     * @param[in] name: thread name in the report
+     */
+    Registration Register(const char *name);
+
+    void MarkStart(); //sample every thread as measuring starts
+    void MarkEnd();   //sample every live thread as measuring ends
+
+    std::vector<Entry> entries();
+
+private:
+    void Exit(int index);
+
+    std::mutex mtx_;
+    std::vector<Entry> entries_;
+    bool measuring_ = false; //between MarkStart() and MarkEnd()
+};
+
+/**
+ * Everything the pipeline counted between warm-up end and bench end.
+ */
+struct BenchStats
+{
+    std::string model;
+    int mode = 0;
+    int in_flight = 0;
+    int post_workers = 0;
+    int ring_depth = 0;
+    int warmup_frames = 0;
+    uint64_t frames = 0; //frames drawn after warm-up
+    double seconds = 0;
+    uint64_t ring_dropped = 0; //frames discarded by the work ring
+    uint64_t pool_exhausted = 0; //frames dropped,or waits,for a free tensor group
+    uint64_t capture_failures = 0; //GetFrame calls without a frame
+    bool completed = false; //false if interrupted before the frame count or duration
+};
+
+/**
+ * Write stats,the StageLatency histograms and ThreadCpuTimes as json.
+ * @param[in] path: output file,empty for stdout
+ * @return 0 if success
+ */
+int WriteBenchReport(const std::string &path, const BenchStats &stats);
+
+#endif // bench_report
@@ -0,0 +1,91 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: keeps several bpu inferences in flight with hbDNNInfer task
+ *               handles and hands them to post processing in frame order
+ ***************************************************************************/
+#ifndef bpu_async_infer
+#define bpu_async_infer
+
+#include <thread>
+#include <vector>
+#include "sp_bpu.h"
+#include "dnn/hb_dnn.h"
+#include "dnn/hb_sys.h"
+#include "spsc_ring.hpp"
+#include "bpu_tensor_pool.hpp"
+
+#define BPU_MAX_IN_FLIGHT 4 //upper limit of inferences running on the bpu at the same time
+
+/**
+ * Each in flight inference owns one input tensor, so capturing and pre
+ * processing the next frame overlaps with the running inferences. The feed
+ * thread takes a free input tensor with AcquireInput(), lets the vio write
+ * the frame straight into it and submits it, so no cpu copy of the pixels
+ * is made on the way to the bpu. A completion thread waits for the tasks in
+ * submission order and pushes the finished work to done_ring, which it
+ * closes once every submitted task completed.
+ */
+class BpuAsyncInfer
+{
+public:
+    BpuAsyncInfer(SpscRing<bpu_work> &done_ring, BpuTensorPool &pool);
+    ~BpuAsyncInfer();
+
+    /**
+     * Allocate the input tensors and start the completion thread.
+     * @param[in] bpu: loaded model
+     * @param[in] in_flight: inferences kept in flight,1~BPU_MAX_IN_FLIGHT
+     * @param[in] frame_size: bytes of one nv12 model input frame
+     * @return 0 if success
+     */
+    int Start(bpu_module *bpu, int in_flight, int frame_size);
+
+    /**
+     * Take a free input tensor,blocks while every input tensor is in flight.
+     * @return nullptr once stopped
+     */
+    hbDNNTensor *AcquireInput();
+
+    /**
+     * Give back an input tensor that will not be submitted.
+     */
+    void ReturnInput(hbDNNTensor *input);
+
+    /**
+     * Submit an input tensor filled by the caller.
+     * @param[in] input: tensor from AcquireInput()
+     * @param[in] work: the lease receives the outputs,ownership passes to
+     *                  BpuAsyncInfer even if submitting fails
+     * @return 0 if success
+     */
+    int Submit(hbDNNTensor *input, const bpu_work &work);
+
+    /**
+     * Wait for the tasks in flight, then stop the completion thread.
+     */
+    void Stop();
+
+private:
+    struct InflightTask
+    {
+        hbDNNTaskHandle_t task;
+        int input_slot;
+        bpu_work work;
+    };
+
+    void CompletionLoop();
+
+    bpu_module *bpu_ = nullptr;
+    SpscRing<bpu_work> &done_ring_;
+    BpuTensorPool &pool_;
+    SpscRing<InflightTask> inflight_ring_; //feed thread -> completion thread
+    SpscRing<int> free_slots_; //completion thread -> feed thread
+    std::vector<hbDNNTensor> input_tensors_;
+    hbDNNTensor *spare_input_ = nullptr; //returned by the feed thread,handed out again first
+    std::thread completion_thread_;
+    bool started_ = false;
+};
+
+#endif // bpu_async_infer
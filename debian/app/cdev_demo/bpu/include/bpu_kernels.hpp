@@ -0,0 +1,588 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: argmax,exp,sigmoid and softmax kernels shared by the post
+ *               processors,neon on aarch64 and scalar everywhere else
+ ***************************************************************************/
+#ifndef bpu_kernels
+#define bpu_kernels
+
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BPU_KERNELS_NEON 1
+#endif
+
+/**
+ * Accuracy of Exp and everything built on it.
+ */
+enum class KernelAccuracy
+{
+    kExact,   //std::exp,the reference
+    kFast,    //range reduction + degree 6 polynomial,relative error ~1e-7
+    kFastest, //exponent bit trick,relative error up to ~4%,still monotonic
+};
+
+namespace kernel_detail
+{
+constexpr float kExpMin = -87.3f; //2^-126,smallest normal float
+constexpr float kExpMax = 88.3f;  //2^127 * e^0.28,still finite
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+//cephes expf polynomial
+constexpr float kP0 = 1.9875691500e-4f;
+constexpr float kP1 = 1.3981999507e-3f;
+constexpr float kP2 = 8.3334519073e-3f;
+constexpr float kP3 = 4.1665795894e-2f;
+constexpr float kP4 = 1.6666665459e-1f;
+constexpr float kP5 = 5.0000001201e-1f;
+//schraudolph:the float bits of 2^(x*log2e),linear inside each octave
+constexpr float kBitScale = 12102203.1616540672f;
+constexpr float kBitOffset = 1064807160.56887296f;
+
+inline float ClampExpInput(float x)
+{
+    return x < kExpMin ? kExpMin : (x > kExpMax ? kExpMax : x);
+}
+
+inline float ExpFastScalar(float x)
+{
+    x = ClampExpInput(x);
+    float n = std::floor(x * kLog2e + 0.5f);
+    float r = x - n * kLn2Hi - n * kLn2Lo;
+    float p = ((((kP0 * r + kP1) * r + kP2) * r + kP3) * r + kP4) * r + kP5;
+    p = p * r * r + r + 1.0f;
+    int32_t bits = ((int32_t)n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+inline float ExpFastestScalar(float x)
+{
+    int32_t bits = (int32_t)(kBitScale * ClampExpInput(x) + kBitOffset);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#ifdef BPU_KERNELS_NEON
+inline float32x4_t ClampExpInput(float32x4_t x)
+{
+    return vminq_f32(vmaxq_f32(x, vdupq_n_f32(kExpMin)), vdupq_n_f32(kExpMax));
+}
+
+inline float32x4_t ExpFast(float32x4_t x)
+{
+    x = ClampExpInput(x);
+    float32x4_t n = vrndmq_f32(vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(kLog2e))); //floor
+    float32x4_t r = vmlsq_f32(x, n, vdupq_n_f32(kLn2Hi));
+    r = vmlsq_f32(r, n, vdupq_n_f32(kLn2Lo));
+    float32x4_t p = vmlaq_f32(vdupq_n_f32(kP1), vdupq_n_f32(kP0), r);
+    p = vmlaq_f32(vdupq_n_f32(kP2), p, r);
+    p = vmlaq_f32(vdupq_n_f32(kP3), p, r);
+    p = vmlaq_f32(vdupq_n_f32(kP4), p, r);
+    p = vmlaq_f32(vdupq_n_f32(kP5), p, r);
+    p = vmlaq_f32(vaddq_f32(r, vdupq_n_f32(1.0f)), p, vmulq_f32(r, r));
+    int32x4_t bits = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+    return vmulq_f32(p, vreinterpretq_f32_s32(bits));
+}
+
+inline float32x4_t ExpFastest(float32x4_t x)
+{
+    float32x4_t bits = vmlaq_f32(vdupq_n_f32(kBitOffset), ClampExpInput(x), vdupq_n_f32(kBitScale));
+    return vreinterpretq_f32_s32(vcvtq_s32_f32(bits));
+}
+
+//1 / x,estimate refined by two newton steps,as exact as a division
+inline float32x4_t Reciprocal(float32x4_t x)
+{
+    float32x4_t estimate = vrecpeq_f32(x);
+    estimate = vmulq_f32(vrecpsq_f32(x, estimate), estimate);
+    return vmulq_f32(vrecpsq_f32(x, estimate), estimate);
+}
+
+inline float32x4_t LoadAsFloat(const float *data) { return vld1q_f32(data); }
+inline float32x4_t LoadAsFloat(const int32_t *data) { return vcvtq_f32_s32(vld1q_s32(data)); }
+inline float32x4_t LoadAsFloat(const int16_t *data) { return vcvtq_f32_s32(vmovl_s16(vld1_s16(data))); }
+inline float32x4_t LoadAsFloat(const int8_t *data)
+{
+    int32_t packed;
+    memcpy(&packed, data, sizeof(packed)); //only 4 of the 8 bytes vld1_s8 would read
+    int16x8_t wide = vmovl_s8(vreinterpret_s8_s32(vdup_n_s32(packed)));
+    return vcvtq_f32_s32(vmovl_s16(vget_low_s16(wide)));
+}
+#endif
+} // namespace kernel_detail
+
+/**
+ * e^x of one value,inputs are clamped to the normal float range except for kExact.
+ */
+template <KernelAccuracy accuracy>
+inline float Exp(float x)
+{
+    return accuracy == KernelAccuracy::kExact ? std::exp(x)
+                                              : (accuracy == KernelAccuracy::kFast ? kernel_detail::ExpFastScalar(x)
+                                                                                   : kernel_detail::ExpFastestScalar(x));
+}
+
+template <KernelAccuracy accuracy>
+inline float Sigmoid(float x)
+{
+    return 1.0f / (1.0f + Exp<accuracy>(-x));
+}
+
+/**
+ * out[i] = e^in[i],in and out may be the same array.
+ */
+template <KernelAccuracy accuracy>
+inline void ExpN(const float *in, float *out, int n)
+{
+    int i = 0;
+#ifdef BPU_KERNELS_NEON
+    if (accuracy != KernelAccuracy::kExact)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t x = vld1q_f32(in + i);
+            vst1q_f32(out + i, accuracy == KernelAccuracy::kFast ? kernel_detail::ExpFast(x) : kernel_detail::ExpFastest(x));
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = Exp<accuracy>(in[i]);
+    }
+}
+
+/**
+ * out[i] = 1 / (1 + e^-in[i]),in and out may be the same array.
+ */
+template <KernelAccuracy accuracy>
+inline void SigmoidN(const float *in, float *out, int n)
+{
+    int i = 0;
+#ifdef BPU_KERNELS_NEON
+    if (accuracy != KernelAccuracy::kExact)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t x = vnegq_f32(vld1q_f32(in + i));
+            float32x4_t e = accuracy == KernelAccuracy::kFast ? kernel_detail::ExpFast(x) : kernel_detail::ExpFastest(x);
+            vst1q_f32(out + i, kernel_detail::Reciprocal(vaddq_f32(e, vdupq_n_f32(1.0f))));
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = Sigmoid<accuracy>(in[i]);
+    }
+}
+
+/**
+ * Sum of e^in[i],no max subtraction,for softmax denominators of bounded logits.
+ */
+template <KernelAccuracy accuracy>
+inline float ExpSum(const float *in, int n)
+{
+    float sum = 0;
+    int i = 0;
+#ifdef BPU_KERNELS_NEON
+    if (accuracy != KernelAccuracy::kExact)
+    {
+        float32x4_t sum4 = vdupq_n_f32(0);
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t x = vld1q_f32(in + i);
+            sum4 = vaddq_f32(sum4, accuracy == KernelAccuracy::kFast ? kernel_detail::ExpFast(x) : kernel_detail::ExpFastest(x));
+        }
+        sum = vaddvq_f32(sum4);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        sum += Exp<accuracy>(in[i]);
+    }
+    return sum;
+}
+
+/**
+ * First index of the largest element,like std::max_element. 0 if n <= 0.
+ */
+inline int Argmax(const float *data, int n)
+{
+    int best = 0;
+    int i = 1;
+#ifdef BPU_KERNELS_NEON
+    if (n >= 8)
+    {
+        //every lane keeps the first index of its own maximum
+        float32x4_t max4 = vld1q_f32(data);
+        uint32x4_t index4 = {0, 1, 2, 3};
+        uint32x4_t next4 = vaddq_u32(index4, vdupq_n_u32(4));
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            float32x4_t value4 = vld1q_f32(data + i);
+            uint32x4_t greater = vcgtq_f32(value4, max4);
+            max4 = vbslq_f32(greater, value4, max4);
+            index4 = vbslq_u32(greater, next4, index4);
+            next4 = vaddq_u32(next4, vdupq_n_u32(4));
+        }
+        float max = vmaxvq_f32(max4);
+        uint32x4_t is_max = vceqq_f32(max4, vdupq_n_f32(max));
+        best = vminvq_u32(vbslq_u32(is_max, index4, vdupq_n_u32(UINT32_MAX)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        if (data[i] > data[best])
+            best = i;
+    }
+    return n > 0 ? best : 0;
+}
+
+inline int Argmax(const int32_t *data, int n)
+{
+    int best = 0;
+    int i = 1;
+#ifdef BPU_KERNELS_NEON
+    if (n >= 8)
+    {
+        int32x4_t max4 = vld1q_s32(data);
+        uint32x4_t index4 = {0, 1, 2, 3};
+        uint32x4_t next4 = vaddq_u32(index4, vdupq_n_u32(4));
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            int32x4_t value4 = vld1q_s32(data + i);
+            uint32x4_t greater = vcgtq_s32(value4, max4);
+            max4 = vbslq_s32(greater, value4, max4);
+            index4 = vbslq_u32(greater, next4, index4);
+            next4 = vaddq_u32(next4, vdupq_n_u32(4));
+        }
+        int32_t max = vmaxvq_s32(max4);
+        uint32x4_t is_max = vceqq_s32(max4, vdupq_n_s32(max));
+        best = vminvq_u32(vbslq_u32(is_max, index4, vdupq_n_u32(UINT32_MAX)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        if (data[i] > data[best])
+            best = i;
+    }
+    return n > 0 ? best : 0;
+}
+
+inline int Argmax(const int16_t *data, int n)
+{
+    int best = 0;
+    int i = 1;
+#ifdef BPU_KERNELS_NEON
+    if (n >= 16 && n <= UINT16_MAX)
+    {
+        int16x8_t max8 = vld1q_s16(data);
+        uint16x8_t index8 = {0, 1, 2, 3, 4, 5, 6, 7};
+        uint16x8_t next8 = vaddq_u16(index8, vdupq_n_u16(8));
+        for (i = 8; i + 8 <= n; i += 8)
+        {
+            int16x8_t value8 = vld1q_s16(data + i);
+            uint16x8_t greater = vcgtq_s16(value8, max8);
+            max8 = vbslq_s16(greater, value8, max8);
+            index8 = vbslq_u16(greater, next8, index8);
+            next8 = vaddq_u16(next8, vdupq_n_u16(8));
+        }
+        int16_t max = vmaxvq_s16(max8);
+        uint16x8_t is_max = vceqq_s16(max8, vdupq_n_s16(max));
+        best = vminvq_u16(vbslq_u16(is_max, index8, vdupq_n_u16(UINT16_MAX)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        if (data[i] > data[best])
+            best = i;
+    }
+    return n > 0 ? best : 0;
+}
+
+inline int Argmax(const int8_t *data, int n)
+{
+    int best = 0;
+    int i = 1;
+#ifdef BPU_KERNELS_NEON
+    if (n >= 16 && n <= UINT16_MAX)
+    {
+        //widened to 16 bits,8 bit lanes could not index past 255
+        int16x8_t max8 = vmovl_s8(vld1_s8(data));
+        uint16x8_t index8 = {0, 1, 2, 3, 4, 5, 6, 7};
+        uint16x8_t next8 = vaddq_u16(index8, vdupq_n_u16(8));
+        for (i = 8; i + 8 <= n; i += 8)
+        {
+            int16x8_t value8 = vmovl_s8(vld1_s8(data + i));
+            uint16x8_t greater = vcgtq_s16(value8, max8);
+            max8 = vbslq_s16(greater, value8, max8);
+            index8 = vbslq_u16(greater, next8, index8);
+            next8 = vaddq_u16(next8, vdupq_n_u16(8));
+        }
+        int16_t max = vmaxvq_s16(max8);
+        uint16x8_t is_max = vceqq_s16(max8, vdupq_n_s16(max));
+        best = vminvq_u16(vbslq_u16(is_max, index8, vdupq_n_u16(UINT16_MAX)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        if (data[i] > data[best])
+            best = i;
+    }
+    return n > 0 ? best : 0;
+}
+
+/**
+ * Argmax of data[i] * scale[i],per channel dequantized int32/int16/int8.
+ * With one positive scale for every channel call Argmax on the raw values.
+ * @param[out] max_value: data[best] * scale[best],may be nullptr
+ * @return first index of the largest dequantized value
+ */
+template <class T>
+inline int ArgmaxScaled(const T *data, const float *scale, int n, float *max_value)
+{
+    int best = 0;
+    float max = n > 0 ? data[0] * scale[0] : 0;
+    int i = 1;
+#ifdef BPU_KERNELS_NEON
+    if (n >= 8)
+    {
+        float32x4_t max4 = vmulq_f32(kernel_detail::LoadAsFloat(data), vld1q_f32(scale));
+        uint32x4_t index4 = {0, 1, 2, 3};
+        uint32x4_t next4 = vaddq_u32(index4, vdupq_n_u32(4));
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            float32x4_t value4 = vmulq_f32(kernel_detail::LoadAsFloat(data + i), vld1q_f32(scale + i));
+            uint32x4_t greater = vcgtq_f32(value4, max4);
+            max4 = vbslq_f32(greater, value4, max4);
+            index4 = vbslq_u32(greater, next4, index4);
+            next4 = vaddq_u32(next4, vdupq_n_u32(4));
+        }
+        max = vmaxvq_f32(max4);
+        uint32x4_t is_max = vceqq_f32(max4, vdupq_n_f32(max));
+        best = vminvq_u32(vbslq_u32(is_max, index4, vdupq_n_u32(UINT32_MAX)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float value = data[i] * scale[i];
+        if (value > max)
+        {
+            max = value;
+            best = i;
+        }
+    }
+    if (max_value)
+        *max_value = max;
+    return best;
+}
+
+/**
+ * out[i] = data[i] * scale[i]
+ */
+template <class T>
+inline void DequantizeScaled(const T *data, const float *scale, float *out, int n)
+{
+    int i = 0;
+#ifdef BPU_KERNELS_NEON
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f32(out + i, vmulq_f32(kernel_detail::LoadAsFloat(data + i), vld1q_f32(scale + i)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = data[i] * scale[i];
+    }
+}
+
+/**
+ * Element i of a float output (scale nullptr) or of a SCALE quantized one,
+ * the elements are step apart in data.
+ */
+template <class T>
+inline float DequantizeAt(const T *data, const float *scale, int i, int step = 1)
+{
+    return scale ? data[i * step] * scale[i] : (float)data[i * step];
+}
+
+/**
+ * Argmax of a float output (scale nullptr) or of a SCALE quantized one.
+ * @param[out] max_value: dequantized value of the winner
+ */
+template <class T>
+inline int ArgmaxDequantized(const T *data, const float *scale, int n, float *max_value)
+{
+    if (scale)
+        return ArgmaxScaled(data, scale, n, max_value);
+    int best = Argmax(data, n);
+    *max_value = n > 0 ? (float)data[best] : 0;
+    return best;
+}
+
+/**
+ * ArgmaxDequantized of n values step elements apart,e.g. the channels of
+ * one cell of a planar output. scale is per channel and stays contiguous.
+ */
+template <class T>
+inline int ArgmaxDequantizedStrided(const T *data, int step, const float *scale, int n, float *max_value)
+{
+    int best = 0;
+    float best_value = n > 0 ? DequantizeAt(data, scale, 0, step) : 0;
+    for (int i = 1; i < n; i++)
+    {
+        float value = DequantizeAt(data, scale, i, step);
+        if (value > best_value)
+        {
+            best_value = value;
+            best = i;
+        }
+    }
+    *max_value = best_value;
+    return best;
+}
+
+/**
+ * sum(data[i] * weights[i]),one row of a gemv. For a SCALE quantized data
+ * fold the per channel scale into weights.
+ */
+template <class T>
+inline float Dot(const T *data, const float *weights, int n)
+{
+    float sum = 0;
+    int i = 0;
+#ifdef BPU_KERNELS_NEON
+    float32x4_t sum4 = vdupq_n_f32(0);
+    for (; i + 4 <= n; i += 4)
+    {
+        sum4 = vmlaq_f32(sum4, kernel_detail::LoadAsFloat(data + i), vld1q_f32(weights + i));
+    }
+    sum = vaddvq_f32(sum4);
+#endif
+    for (; i < n; i++)
+    {
+        sum += data[i] * weights[i];
+    }
+    return sum;
+}
+
+/**
+ * out[i] += weight * data[i],one column of a gemv over planar data.
+ */
+template <class T>
+inline void Axpy(float weight, const T *data, float *out, int n)
+{
+    int i = 0;
+#ifdef BPU_KERNELS_NEON
+    float32x4_t weight4 = vdupq_n_f32(weight);
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), kernel_detail::LoadAsFloat(data + i), weight4));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] += weight * data[i];
+    }
+}
+
+/**
+ * Smallest q with q * scale >= threshold,comparing the raw integer of a SCALE
+ * quantized output against it gives the same answer as comparing the
+ * dequantized float against threshold.
+ */
+inline int32_t QuantizedThreshold(float threshold, float scale)
+{
+    if (!(scale > 0))
+        return threshold <= 0 ? INT32_MIN : INT32_MAX;
+    double q = std::ceil((double)threshold / scale);
+    if (q <= INT32_MIN)
+        return INT32_MIN;
+    if (q >= INT32_MAX)
+        return INT32_MAX;
+    //the float product rounds,step onto its exact boundary
+    int32_t value = (int32_t)q;
+    while (value > INT32_MIN && (value - 1) * scale >= threshold)
+        value--;
+    while (value < INT32_MAX && value * scale < threshold)
+        value++;
+    return value;
+}
+
+/**
+ * Numerically stable softmax,out[i] = e^(in[i] - max) / sum,in and out may
+ * be the same array.
+ */
+template <KernelAccuracy accuracy>
+inline void Softmax(const float *in, float *out, int n)
+{
+    if (n <= 0)
+        return;
+    float max = in[Argmax(in, n)];
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = in[i] - max;
+    }
+    ExpN<accuracy>(out, out, n);
+    float sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += out[i];
+    }
+    float inverse = 1.0f / sum;
+    for (int i = 0; i < n; i++)
+    {
+        out[i] *= inverse;
+    }
+}
+
+/**
+ * Expected bin index under softmax(logits),sum(i * p[i]) over n bins,the
+ * box side of a distribution focal loss head. Max subtracted,no array is
+ * written.
+ */
+template <KernelAccuracy accuracy>
+inline float SoftmaxExpectation(const float *logits, int n)
+{
+    if (n <= 0)
+        return 0;
+    float max = logits[Argmax(logits, n)];
+    float sum = 0;
+    float weighted = 0;
+    int i = 0;
+#ifdef BPU_KERNELS_NEON
+    if (accuracy != KernelAccuracy::kExact)
+    {
+        float32x4_t max4 = vdupq_n_f32(max);
+        float32x4_t index4 = {0, 1, 2, 3};
+        float32x4_t sum4 = vdupq_n_f32(0);
+        float32x4_t weighted4 = vdupq_n_f32(0);
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t x = vsubq_f32(vld1q_f32(logits + i), max4);
+            float32x4_t e = accuracy == KernelAccuracy::kFast ? kernel_detail::ExpFast(x) : kernel_detail::ExpFastest(x);
+            sum4 = vaddq_f32(sum4, e);
+            weighted4 = vmlaq_f32(weighted4, e, index4);
+            index4 = vaddq_f32(index4, vdupq_n_f32(4));
+        }
+        sum = vaddvq_f32(sum4);
+        weighted = vaddvq_f32(weighted4);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float e = Exp<accuracy>(logits[i] - max);
+        sum += e;
+        weighted += i * e;
+    }
+    return weighted / sum;
+}
+
+#endif // bpu_kernels
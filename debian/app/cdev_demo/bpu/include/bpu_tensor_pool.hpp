@@ -0,0 +1,139 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: pool of bpu output tensor groups handed out as ref counted
+ *               leases,sized from the model output count
+ ***************************************************************************/
+#ifndef bpu_tensor_pool
+#define bpu_tensor_pool
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "sp_bpu.h"
+#include "dnn/hb_dnn.h"
+#include "spsc_ring.hpp"
+#include "stage_latency.hpp"
+
+/**
+ * One set of output tensors,enough for one inference.
+ */
+struct BpuTensorGroup
+{
+    hbDNNTensor *tensors;
+    int index;
+    std::atomic<int> refs;
+};
+
+/**
+ * A frame travelling through the rings. The work owns one reference of lease.
+ */
+typedef struct
+{
+    BpuTensorGroup * lease;
+    LatencyClock::time_point capture_time; //before the frame was captured
+    LatencyClock::time_point submit_time; //after the bpu task was submitted
+}bpu_work;
+
+/**
+ * What Acquire() does when every group is leased.
+ */
+enum class PoolExhaustPolicy
+{
+    kBlock, //wait until a group is released
+    kDrop,  //return nullptr,the caller drops the frame
+};
+
+/**
+ * Groups are only reused once every lease on them is released,so the bpu
+ * never writes into tensors that are still being decoded.
+ */
+class BpuTensorPool
+{
+public:
+    BpuTensorPool() = default;
+    ~BpuTensorPool();
+
+    BpuTensorPool(const BpuTensorPool &) = delete;
+    BpuTensorPool &operator=(const BpuTensorPool &) = delete;
+
+    /**
+     * Query the output count with hbDNNGetOutputCount and init the tensors.
+     * @param[in] bpu: loaded model
+     * @param[in] groups: number of tensor groups
+     * @param[in] policy: behaviour of Acquire() when exhausted
+     * @return 0 if success
+     */
+    int Init(bpu_module *bpu, int groups, PoolExhaustPolicy policy);
+
+    /**
+     * Release the tensors,no lease may be in use.
+     */
+    void Deinit();
+
+    /**
+     * Lease a free group with one reference.
+     * @return nullptr if exhausted with kDrop,or once the pool is closed
+     */
+    BpuTensorGroup *Acquire();
+
+    void AddRef(BpuTensorGroup *group);
+
+    /**
+     * Drop one reference,the last one returns the group to the pool.
+     */
+    void Release(BpuTensorGroup *group);
+
+    /**
+     * Wake up Acquire() waiters,they return nullptr from now on.
+     */
+    void Close();
+
+    int output_count() const { return output_count_; }
+    int groups() const { return group_count_; }
+    int in_use() const { return in_use_.load(std::memory_order_relaxed); }
+    int high_water() const { return high_water_.load(std::memory_order_relaxed); }
+    // Acquire() calls that found the pool empty
+    uint64_t exhausted() const { return exhausted_.load(std::memory_order_relaxed); }
+
+private:
+    int output_count_ = 0;
+    PoolExhaustPolicy policy_ = PoolExhaustPolicy::kBlock;
+    std::vector<hbDNNTensor> tensors_; //groups x output_count_
+    std::unique_ptr<BpuTensorGroup[]> groups_;
+    int group_count_ = 0; //groups with initialized tensors
+    std::vector<BpuTensorGroup *> free_;
+    bool closed_ = false;
+    std::mutex mtx_;
+    std::condition_variable free_cv_;
+    std::atomic<int> in_use_{0};
+    std::atomic<int> high_water_{0};
+    std::atomic<uint64_t> exhausted_{0};
+};
+
+/**
+ * Queue a work and release the lease of whatever the ring discarded.
+ */
+inline void PushWork(SpscRing<bpu_work> &ring, BpuTensorPool &pool, const bpu_work &work)
+{
+    bpu_work evicted;
+    switch (ring.push(work, &evicted))
+    {
+    case RingPushResult::kPushed:
+        break;
+    case RingPushResult::kEvicted:
+        pool.Release(evicted.lease);
+        break;
+    case RingPushResult::kDropped:
+    case RingPushResult::kClosed:
+        pool.Release(work.lease);
+        break;
+    }
+}
+
+#endif // bpu_tensor_pool
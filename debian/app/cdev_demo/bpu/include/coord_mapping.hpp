@@ -0,0 +1,77 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: model input -> display coordinates,built once per pipeline
+ *               from the geometry the pre processing used
+ ***************************************************************************/
+#ifndef coord_mapping
+#define coord_mapping
+
+#include "sp_bpu.h"
+#include "detection_batch.hpp"
+
+/**
+ * How the model input was made,in display coordinates (the display shows
+ * the whole source frame): the display rect
+ * crop_x,crop_y,crop_width x crop_height was scaled to resize_width x
+ * resize_height and written at pad_x,pad_y of the model input,the rest
+ * of the input is border.
+ */
+struct InputGeometry
+{
+    int crop_x;
+    int crop_y;
+    int crop_width;
+    int crop_height;
+    int resize_width;
+    int resize_height;
+    int pad_x;
+    int pad_y;
+
+    /**
+     * The whole display scaled to the whole model input,the aspect ratio
+     * is not kept.
+     */
+    static InputGeometry Stretch(const bpu_image_info_t &image_info);
+
+    /**
+     * The whole source frame of source_width x source_height scaled to fit
+     * the model input with its aspect ratio kept,centered,the border on two
+     * sides. The display shows the same frame scaled to its own size,so only
+     * the mapping back uses the display size. Sizes and pads are even,so an
+     * nv12 frame of resize_width x resize_height fits in. An unknown (0)
+     * source size takes the aspect ratio of the display.
+     */
+    static InputGeometry Letterbox(const bpu_image_info_t &image_info, int source_width, int source_height);
+};
+
+/**
+ * display = model * scale + offset,then clipped to the cropped display
+ * rect. Decoders write boxes in model input pixels,Apply() takes them to
+ * the display after nms,so no decoder knows the pre processing.
+ */
+struct CoordMapping
+{
+    float scale_x;  //display pixels per model pixel
+    float scale_y;
+    float offset_x; //display x of model x 0
+    float offset_y;
+    float min_x;    //display rect the model saw,boxes are clipped to it
+    float min_y;
+    float max_x;
+    float max_y;
+
+    static CoordMapping Build(const InputGeometry &geometry);
+
+    float ModelX(float display_x) const { return (display_x - offset_x) / scale_x; }
+    float ModelY(float display_y) const { return (display_y - offset_y) / scale_y; }
+
+    /**
+     * Map every box of batch to the display and clip it,boxes left with
+     * nothing inside the rect are dropped,the order is kept.
+     */
+    void Apply(DetectionBatch &batch) const;
+};
+
+#endif // coord_mapping
@@ -0,0 +1,104 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: detections of one frame as structure of arrays,written by
+ *               every detector and read by nms and drawing as they are
+ ***************************************************************************/
+#ifndef detection_batch
+#define detection_batch
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * Boxes,scores and class ids of the detections of one frame,element i of
+ * every array is detection i. Decoders Reserve() the most detections they
+ * can write and Push() them,the capacity only grows,so after the first
+ * frames a batch never allocates. A detector with a payload per detection
+ * (the mask coefficients of yolov5 seg) gives extra_dim floats to each.
+ * Class names come from the table of the decoder that filled the batch.
+ */
+class DetectionBatch
+{
+public:
+    /**
+     * Room for capacity detections with extra_dim payload floats each,the
+     * detections in the batch are kept. extra_dim must not change while
+     * the batch holds detections.
+     */
+    void Reserve(int capacity, int extra_dim = 0);
+
+    void Clear() { size_ = 0; }
+    int Size() const { return size_; }
+    int Capacity() const { return capacity_; }
+    int ExtraDim() const { return extra_dim_; }
+
+    /**
+     * Append one detection.
+     * @return its index,-1 if the batch is full
+     */
+    int Push(int id, float xmin, float ymin, float xmax, float ymax, float score)
+    {
+        if (size_ == capacity_)
+            return -1;
+        id_[size_] = id;
+        xmin_[size_] = xmin;
+        ymin_[size_] = ymin;
+        xmax_[size_] = xmax;
+        ymax_[size_] = ymax;
+        score_[size_] = score;
+        return size_++;
+    }
+
+    /**
+     * Append the detections of other,the capacity grows as needed.
+     */
+    void Append(const DetectionBatch &other);
+
+    /**
+     * Replace the detections by from[index[0]],...,from[index[count - 1]].
+     */
+    void Gather(const DetectionBatch &from, const int *index, int count);
+
+    /**
+     * x = x * scale_x + offset_x and y = y * scale_y + offset_y on every
+     * box,one pass per coordinate array.
+     */
+    void Map(float scale_x, float scale_y, float offset_x, float offset_y);
+
+    /**
+     * Clamp xmin,ymin up to min_x,min_y and xmax,ymax down to max_x,max_y,
+     * then drop the boxes left with xmin > xmax or ymin > ymax,the others
+     * keep their order.
+     */
+    void Clip(float min_x, float min_y, float max_x, float max_y);
+
+    void SetClassNames(const std::vector<std::string> *class_names) { class_names_ = class_names; }
+    const char *ClassName(int i) const { return class_names_ ? (*class_names_)[id_[i]].c_str() : ""; }
+
+    const int *Id() const { return id_.data(); }
+    const float *XMin() const { return xmin_.data(); }
+    const float *YMin() const { return ymin_.data(); }
+    const float *XMax() const { return xmax_.data(); }
+    const float *YMax() const { return ymax_.data(); }
+    const float *Score() const { return score_.data(); }
+    float *Extra(int i) { return extra_.data() + (size_t)i * extra_dim_; }
+    const float *Extra(int i) const { return extra_.data() + (size_t)i * extra_dim_; }
+
+private:
+    int size_ = 0;
+    int capacity_ = 0;
+    int extra_dim_ = 0;
+    std::vector<int> id_;
+    std::vector<float> xmin_;
+    std::vector<float> ymin_;
+    std::vector<float> xmax_;
+    std::vector<float> ymax_;
+    std::vector<float> score_;
+    std::vector<float> extra_;
+    const std::vector<std::string> *class_names_ = nullptr;
+};
+
+#endif // detection_batch
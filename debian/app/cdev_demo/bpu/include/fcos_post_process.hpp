@@ -15,6 +15,7 @@
 #include <cmath>
 #include <algorithm>
 #include "sp_bpu.h"
+#include "detection_batch.hpp"
 
 struct PTQFcosConfig {
   std::vector<int> strides;
@@ -62,51 +63,7 @@ inline size_t argmin(ForwardIterator first, ForwardIterator last) {
 //   return std::distance(first, std::max_element(first, last));
 // }
 
-/**
- * Bounding box definition
- */
-typedef struct Bbox {
-  float xmin;
-  float ymin;
-  float xmax;
-  float ymax;
-             
-  Bbox() {}  
-             
-  Bbox(float xmin, float ymin, float xmax, float ymax)
-      : xmin(xmin), ymin(ymin), xmax(xmax), ymax(ymax) {}
-             
-  friend std::ostream &operator<<(std::ostream &os, const Bbox &bbox) {
-    os << "[" << std::fixed << std::setprecision(6) << bbox.xmin << ","
-       << bbox.ymin << "," << bbox.xmax << "," << bbox.ymax << "]";
-    return os; 
-  }          
-             
-  ~Bbox() {} 
-} Bbox;
-
-typedef struct Detection {
-  int id; 
-  float score;
-  Bbox bbox;
-  const char *class_name;
-  Detection() {}
- 
-  Detection(int id, float score, Bbox bbox)
-      : id(id), score(score), bbox(bbox) {}
- 
-  Detection(int id, float score, Bbox bbox, const char *class_name)
-      : id(id), score(score), bbox(bbox), class_name(class_name) {}
- 
-  friend bool operator>(const Detection &lhs, const Detection &rhs) {
-    return (lhs.score > rhs.score);
-  }
- 
- 
-  ~Detection() {}
-} Detection;
-
 //extern FcosConfig default_fcos_config;
-void fcos_post_process(hbDNNTensor* tensors ,bpu_image_info_t *post_info,std::vector<Detection> &det_restuls);
+void fcos_post_process(hbDNNTensor* tensors ,DetectionBatch &det_restuls);
 
 #endif
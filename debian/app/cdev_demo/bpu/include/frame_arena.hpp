@@ -0,0 +1,79 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: per thread bump allocator for post process scratch,rewound
+ *               instead of freed so a steady frame loop does not allocate
+ ***************************************************************************/
+#ifndef frame_arena
+#define frame_arena
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Scratch memory of one thread. Alloc() hands out aligned slices of one
+ * block,ArenaScope gives them back on scope exit. When a frame asks for
+ * more than the block holds the rest comes from overflow blocks,and the
+ * next time the arena is empty the block grows to the high water mark,so
+ * after the first frames every Alloc() is a pointer bump.
+ * Only trivially destructible types,nothing is ever destroyed.
+ */
+class FrameArena
+{
+public:
+    FrameArena() = default;
+    ~FrameArena();
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /**
+     * The arena of the calling thread.
+     */
+    static FrameArena &ThisThread();
+
+    /**
+     * Uninitialized storage for count T,valid until the enclosing scope
+     * is rewound.
+     */
+    template <class T>
+    T *Alloc(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destroyed");
+        return static_cast<T *>(Alloc(count * sizeof(T), alignof(T)));
+    }
+
+    size_t Mark() const { return used_; }
+    void Rewind(size_t mark);
+
+private:
+    void *Alloc(size_t bytes, size_t align);
+
+    uint8_t *block_ = nullptr;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    std::vector<uint8_t *> overflow_;
+    size_t peak_ = 0; //largest used_ while serving from overflow blocks
+};
+
+/**
+ * Rewinds the arena to where it was on construction.
+ */
+class ArenaScope
+{
+public:
+    explicit ArenaScope(FrameArena &arena) : arena_(arena), mark_(arena.Mark()) {}
+    ~ArenaScope() { arena_.Rewind(mark_); }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    FrameArena &arena_;
+    size_t mark_;
+};
+
+#endif // frame_arena
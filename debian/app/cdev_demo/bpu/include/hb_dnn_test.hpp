@@ -9,14 +9,6 @@
 
 #include "sp_bpu.h"
 #include "sp_vio.h"
-#include "yolov5_post_process.hpp"
-#include "fcos_post_process.hpp"
-#include "yolov3_post_process.hpp"
-#include "ptq_ssd_post_process_method.hpp"
-#include "ptq_centernet_post_process_method.hpp"
-#include "ptq_centernet_maxpool_sigmoid_post_process_method.hpp"
-#include "ptq_classification_post_process_method.hpp"
-#include "ptq_unet_post_process_method.hpp"
 #include "sp_display.h"
 #include "sp_codec.h"
 #include "sp_sys.h"
@@ -25,12 +17,10 @@
 #include <dnn/hb_sys.h>
 #include <chrono>
 #include <time.h>
-
-typedef struct 
-{
-    hbDNNTensor * payload;
-    std::chrono::system_clock::time_point start_time;
-}bpu_work;
+#include "spsc_ring.hpp"
+#include "model_pipeline.hpp"
+#include "pipeline_stages.hpp"
+#include "pipeline_models.hpp"
 
 static char doc[] = "bpu sample -- An C++ example of using bpu";
 struct arguments
@@ -41,13 +31,49 @@ struct arguments
     int height;
     int width;
     bool debug;
+    std::string queue_policy;
+    int in_flight;
+    int ring_depth;
+    int post_workers;
+    int latency_report_sec;
+    bool bench;
+    int bench_frames;
+    int bench_seconds;
+    int warmup_frames;
+    std::string bench_report_path;
+    std::string replay_path;
+    int replay_fps;
+    bool replay_once;
+};
+enum
+{
+    OPT_BENCH_FRAMES = 256,//long only options
+    OPT_BENCH_SECONDS,
+    OPT_WARMUP,
+    OPT_REPORT,
+    OPT_REPLAY,
+    OPT_REPLAY_FPS,
+    OPT_REPLAY_ONCE,
 };
 static struct argp_option options[] = {
-    {"mode", 'm', "type", 0, "0:yolov5;1:fcos"},
+    {"mode", 'm', "type", 0, "0:yolov5s;1:fcos;2:yolov3;4:yolov5x;5:ssd_mobilenetv1;6:centernet_resnet50;7:centernet_resnet101;8:mobilenetv1;9:unet;10:yolov5s_v6_v7;11:yolov8s;12:yolov5s_seg"},
     {"file", 'f', "modle_file", 0, "path of model file"},
     {"input_video", 'i', "video path", 0, "path of video"},
     {"video_height", 'h', "height", 0, "height of video"},
     {"video_width", 'w', "width", 0, "width of video"},
     {"debug", 'd', 0, 0, "Print lots of debugging information."},
+    {"queue_policy", 'q', "policy", 0, "work queue overflow policy: block(default),drop_oldest,drop_newest"},
+    {"ring_depth", 'r', "depth", 0, "frames queued for post processing,default 3"},
+    {"post_workers", 'p', "num", 0, "post processing threads,1~4,default 1"},
+    {"latency", 'l', "seconds", 0, "print per stage latency histograms every n seconds,SIGUSR1 prints them once"},
+    {"bench", 'b', 0, 0, "headless benchmark,no display,prints a json report"},
+    {"frames", OPT_BENCH_FRAMES, "num", 0, "bench:frames to measure after warm-up,default 1000"},
+    {"duration", OPT_BENCH_SECONDS, "seconds", 0, "bench:seconds to measure after warm-up,overrides --frames"},
+    {"warmup", OPT_WARMUP, "num", 0, "bench:frames discarded before measuring,default 50"},
+    {"report", OPT_REPORT, "path", 0, "bench:write the json report to path instead of stdout"},
+    {"replay", OPT_REPLAY, "path", 0, "replay nv12 frames of the capture size (letterboxed modes:the -w x -h source,1920x1080 by default,scaled to fit the model input,e.g. 672x378 for mode 0;else the model input size,300x300 for mode 8,512x512 for mode 9) from a file,a directory or - (stdin)"},
+    {"replay_fps", OPT_REPLAY_FPS, "fps", 0, "replay:frames per second,default 0 as fast as possible"},
+    {"replay_once", OPT_REPLAY_ONCE, 0, 0, "replay:stop at the end instead of starting over"},
+    {"in_flight", 'n', "num", 0, "bpu inferences in flight,1~4,default 2"},
     {0}};
 #endif
@@ -0,0 +1,79 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: persistent helper threads decoding the output heads of one
+ *               frame in parallel
+ ***************************************************************************/
+#ifndef head_decode_pool
+#define head_decode_pool
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs fn(head) for every output head of a frame,the calling thread takes
+ * heads as well,so count heads need count - 1 helpers. The helpers start on
+ * the first Run() and live until the pool is destroyed,a frame only costs
+ * one wake up. Heads are handed out dynamically,a big head does not hold a
+ * small one back. fn must only write state owned by its head,the caller
+ * merges the per head results after Run() returns.
+ */
+class HeadDecodePool
+{
+public:
+    /**
+     * @param[in] helpers: helper threads,0 runs every head on the caller,
+     *                     capped on the first Run() so that the pools of
+     *                     all the post workers leave one core per worker:
+     *                     cores / post workers - 1
+     */
+    explicit HeadDecodePool(int helpers);
+    ~HeadDecodePool();
+
+    HeadDecodePool(const HeadDecodePool &) = delete;
+    HeadDecodePool &operator=(const HeadDecodePool &) = delete;
+
+    /**
+     * Post workers running a pool each,set by the pipeline before the first
+     * Run() of any pool,1 by default.
+     */
+    static void SetPostWorkers(int workers);
+
+    /**
+     * Call fn(head) for head 0~count-1,returns once every call returned.
+     */
+    template <class Fn>
+    void Run(int count, Fn &fn)
+    {
+        Run(count, [](void *arg, int head) { (*static_cast<Fn *>(arg))(head); }, &fn);
+    }
+
+private:
+    void Run(int count, void (*call)(void *, int), void *arg);
+    void Start();
+    void HelperLoop(int id);
+    void TakeHeads(); //decode heads until none is left
+
+    static std::atomic<int> post_workers_;
+
+    int helpers_;
+    bool started_ = false;
+    std::vector<std::thread> threads_;
+    std::mutex mtx_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_ = 0; //one per Run()
+    int busy_ = 0; //helpers still in the current generation
+    bool stop_ = false;
+    //current job,written under mtx_ before generation_ moves on
+    void (*call_)(void *, int) = nullptr;
+    void *arg_ = nullptr;
+    int count_ = 0;
+    std::atomic<int> next_head_{0};
+};
+
+#endif // head_decode_pool
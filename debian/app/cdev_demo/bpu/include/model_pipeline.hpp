@@ -0,0 +1,476 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: one camera -> bpu -> post process -> display pipeline shared
+ *               by every model of the bpu sample
+ ***************************************************************************/
+#ifndef model_pipeline
+#define model_pipeline
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sp_bpu.h"
+#include "sp_vio.h"
+#include "dnn/hb_dnn.h"
+#include "dnn/hb_sys.h"
+#include "spsc_ring.hpp"
+#include "bpu_tensor_pool.hpp"
+#include "bpu_async_infer.hpp"
+#include "stage_latency.hpp"
+#include "bench_report.hpp"
+#include "coord_mapping.hpp"
+#include "head_decode_pool.hpp"
+
+#define BPU_WORK_RING_DEPTH 3 //default depth of the work ring
+#define BPU_MAX_WORK_RING_DEPTH 16
+#define BPU_MAX_POST_WORKERS 4
+#define BPU_POST_JOB_RING_DEPTH 2 //jobs queued per post processing worker
+
+/**
+ * Runtime settings shared by every stage of a pipeline.
+ */
+struct PipelineContext
+{
+    std::string model_file;
+    std::string video_path; //only used by decoder sources
+    std::string replay_path; //nv12 replay instead of the camera or decoder,see ReplaySource
+    int replay_fps = 0; //0:as fast as possible
+    bool replay_once = false; //stop at the end of the replay instead of starting over
+    int video_w = 0;
+    int video_h = 0;
+    int disp_w = 0; //display resolution
+    int disp_h = 0;
+    bool debug = false;
+    int in_flight = 2; //hbDNNInfer tasks in flight,1 runs them one by one
+    int ring_depth = BPU_WORK_RING_DEPTH; //frames waiting for post processing
+    int post_workers = 1; //post processing threads,1~BPU_MAX_POST_WORKERS
+    RingOverflowPolicy queue_policy = RingOverflowPolicy::kBlock;
+    int latency_report_sec = 0; //print the stage latency histograms every n seconds,0:only on request
+    int mode = 0; //registration table mode,for the bench report
+    bool bench = false; //headless benchmark,stops by itself and writes a json report
+    int bench_frames = 0; //frames to measure after warm-up,0:BENCH_FRAMES unless bench_seconds is set
+    int bench_seconds = 0; //seconds to measure after warm-up
+    int warmup_frames = BENCH_WARMUP_FRAMES;
+    std::string bench_report_path; //json report path,empty for stdout
+    std::atomic<bool> *is_stop = nullptr; //runing flag,set by the signal handler
+    std::atomic<bool> *latency_dump = nullptr; //set by the SIGUSR1 handler to print the histograms once
+};
+
+/**
+ * Feed thread: Source -> PreProcessor -> bpu -> work ring
+ * Post thread: work ring -> PostProcessor -> Sink
+ *
+ * The feed thread only submits hbDNNInfer tasks, a BpuAsyncInfer completion
+ * thread pushes them to the work ring in frame order. Frames are captured
+ * straight into the bpu input tensor, or into frame_buffer_ when the
+ * PreProcessor has to convert them first.
+ *
+ * Every frame leases its output tensors from a BpuTensorPool, the lease is
+ * released after drawing or when a ring discards the frame.
+ *
+ * With ctx.post_workers > 1 a dispatcher spreads the works over several
+ * post processing threads, each with its own PostProcessor and Result
+ * scratch. Finished workers take turns by frame sequence to draw, so the
+ * sink still sees the frames in order.
+ *
+ * Source      opens the video input and fills a frame of the capture size:
+ *             FrameSize(ctx, &w, &h) (static,the size the vio scales from),
+ *             Open(ctx, w, h),GetFrame(buffer, w, h),Close(),vio() (the vio
+ *             module bound to the display,or nullptr)
+ * PreProcessor turns a captured frame into the model input tensor:
+ *             Init(image_info, source_w, source_h) returns the InputGeometry
+ *             it uses,then
+ *             CaptureWidth(),CaptureHeight() give the frame size it wants
+ *             and CaptureToInput() whether the frame is the input already,
+ *             else Process(frame, input) fills the input from it
+ * PostProcessor carries the per model constants (input size, output tensor
+ *             count, Result type) and decodes output tensors into a Result,
+ *             boxes go to the display through the CoordMapping built from
+ *             that geometry
+ * Sink        renders a Result
+ */
+template <class Source, class PreProcessor, class PostProcessor, class Sink>
+class ModelPipeline
+{
+    static_assert(PreProcessor::kOutputWidth == PostProcessor::kModelWidth &&
+                      PreProcessor::kOutputHeight == PostProcessor::kModelHeight,
+                  "pre processor output must match the model input size");
+
+public:
+    explicit ModelPipeline(PipelineContext &ctx)
+        : ctx_(ctx), post_workers_(ctx.post_workers), work_ring_(ctx.ring_depth, ctx.queue_policy), async_infer_(work_ring_, pool_)
+    {
+        HeadDecodePool::SetPostWorkers(post_workers_); //the head decode helpers of all the workers share the cores
+        image_info_.m_model_w = PostProcessor::kModelWidth;
+        image_info_.m_model_h = PostProcessor::kModelHeight; //input tensor size
+        image_info_.m_ori_width = ctx.disp_w ? ctx.disp_w : PostProcessor::kModelWidth;
+        image_info_.m_ori_height = ctx.disp_h ? ctx.disp_h : PostProcessor::kModelHeight; //origin size,model size when headless
+        int source_width = 0;
+        int source_height = 0;
+        Source::FrameSize(ctx, &source_width, &source_height); //the aspect ratio of what the vio scales
+        mapping_ = CoordMapping::Build(pre_.Init(image_info_, source_width, source_height));
+        if (!pre_.CaptureToInput())
+            frame_buffer_.resize(FRAME_BUFFER_SIZE(pre_.CaptureWidth(), pre_.CaptureHeight()));
+    }
+
+    int Run()
+    {
+        bpu_handle_ = sp_init_bpu_module(ctx_.model_file.c_str());
+        if (!bpu_handle_)
+        {
+            printf("%s load model %s failed\n", PostProcessor::Name(), ctx_.model_file.c_str());
+            return -1;
+        }
+        //every queued,running and post processing frame holds one group,plus
+        //the one the completion thread is pushing while the ring is full
+        int post_holders = post_workers_ == 1 ? 1 : post_workers_ * (BPU_POST_JOB_RING_DEPTH + 1) + 1; //+1:dispatcher waiting for a worker
+        int tensor_groups = ctx_.ring_depth + ctx_.in_flight + 1 + post_holders;
+        PoolExhaustPolicy exhaust_policy = ctx_.queue_policy == RingOverflowPolicy::kBlock ? PoolExhaustPolicy::kBlock : PoolExhaustPolicy::kDrop;
+        int ret = pool_.Init(bpu_handle_, tensor_groups, exhaust_policy);
+        if (!ret && pool_.output_count() != PostProcessor::kOutputCount)
+        {
+            printf("model has %d outputs,%s expects %d\n", pool_.output_count(), PostProcessor::Name(), PostProcessor::kOutputCount);
+            ret = -1;
+        }
+        if (!ret)
+            ret = source_.Open(ctx_, pre_.CaptureWidth(), pre_.CaptureHeight());
+        if (!ret)
+        {
+            ret = sink_.Open(ctx_, source_.vio());
+            if (!ret)
+            {
+                ret = async_infer_.Start(bpu_handle_, ctx_.in_flight, kModelInputSize);
+                if (ret)
+                    sink_.Close(source_.vio());
+            }
+            if (!ret)
+            {
+                std::thread feed_thread(&ModelPipeline::FeedLoop, this); //start pre processing thread
+                std::thread post_thread(&ModelPipeline::PostThreads, this); //start post processing threads
+                feed_thread.join();
+                post_thread.join();
+                sink_.Close(source_.vio());
+            }
+            async_infer_.Stop(); //release the input tensors
+            source_.Close();
+        }
+        //both threads are joined,nobody is reading the tensors anymore
+        pool_.Deinit();
+        if (ctx_.debug || ctx_.latency_report_sec)
+            StageLatency::Get().Dump(PostProcessor::Name());
+        if (ctx_.bench && !ret)
+            ret = WriteBenchReport(ctx_.bench_report_path, BenchResult());
+        printf("stop bpu!\n");
+        sp_release_bpu_module(bpu_handle_);
+        return ret;
+    }
+
+private:
+    struct PostJob
+    {
+        bpu_work work;
+        uint64_t seq; //frame order
+    };
+
+    struct PostWorker
+    {
+        PostWorker() : jobs(BPU_POST_JOB_RING_DEPTH) {}
+
+        SpscRing<PostJob> jobs; //dispatcher -> worker
+        PostProcessor post;
+        typename PostProcessor::Result results; //reused for every frame
+    };
+
+    void FeedLoop()
+    {
+        ThreadCpuTimes::Registration cpu_time = ThreadCpuTimes::Get().Register("feed");
+        while (!*ctx_.is_stop)
+        {
+            bpu_work work;
+            hbDNNTensor *input = async_infer_.AcquireInput(); //blocks while every input tensor is in flight
+            if (!input)
+                break;
+            char *input_addr = static_cast<char *>(input->sysMem[0].virAddr);
+            char *capture = pre_.CaptureToInput() ? input_addr : frame_buffer_.data();
+            work.capture_time = LatencyClock::now();
+            int ret = source_.GetFrame(capture, pre_.CaptureWidth(), pre_.CaptureHeight());
+            if (ret)
+            {
+                async_infer_.ReturnInput(input);
+                if (ret < 0)
+                    break;
+                capture_failures_.fetch_add(1, std::memory_order_relaxed);
+                continue; //no frame this time,try again
+            }
+            LatencyClock::time_point stage_start = RecordStage(kStageCapture, work.capture_time);
+            if (!pre_.CaptureToInput())
+            {
+                pre_.Process(capture, input_addr);
+                RecordStage(kStagePreprocess, stage_start);
+            }
+            work.lease = pool_.Acquire(); //blocks or returns nullptr according to the exhaust policy
+            if (!work.lease)
+            {
+                async_infer_.ReturnInput(input);
+                continue; //drop this frame,or the pool is closed and is_stop is set
+            }
+            if (async_infer_.Submit(input, work)) //returns once the task is queued on the bpu
+                break;
+        }
+        async_infer_.Stop(); //the completion thread closes the work ring after the last task
+        printf("%s %s,finish!\n", PostProcessor::Name(), __func__);
+    }
+
+    /**
+     * Dispatcher,only used with several workers: hands the works to the
+     * workers round robin,so frame seq always goes to worker seq % workers.
+     */
+    void PostLoop()
+    {
+        ThreadCpuTimes::Registration cpu_time = ThreadCpuTimes::Get().Register("post_dispatch");
+        bpu_work work;
+        uint64_t seq = 0;
+        while (work_ring_.pop(work)) //blocks until the feed thread pushes work or closes the ring
+        {
+            PostJob job;
+            job.work = work;
+            job.seq = seq;
+            workers_[seq % post_workers_].jobs.push(job); //blocks while that worker is busy
+            seq++;
+        }
+        for (int i = 0; i < post_workers_; i++)
+        {
+            workers_[i].jobs.close(); //workers finish their queued jobs and exit
+        }
+        printf("%s %s,finish!\n", PostProcessor::Name(), __func__);
+    }
+
+    bool NextJob(PostWorker &worker, PostJob &job)
+    {
+        if (post_workers_ == 1)
+        {
+            //single worker reads the work ring directly,no dispatcher hop
+            if (!work_ring_.pop(job.work))
+                return false;
+            job.seq = next_seq_++;
+            return true;
+        }
+        return worker.jobs.pop(job);
+    }
+
+    void WorkerLoop(int id)
+    {
+        char thread_name[32];
+        snprintf(thread_name, sizeof(thread_name), "post_worker_%d", id);
+        ThreadCpuTimes::Registration cpu_time = ThreadCpuTimes::Get().Register(thread_name);
+        PostWorker &worker = workers_[id];
+        PostJob job;
+        while (NextJob(worker, job))
+        {
+            bool stop = *ctx_.is_stop;
+            if (!stop)
+            {
+                hbDNNTensor *tensors = job.work.lease->tensors;
+                for (int i = 0; i < PostProcessor::kOutputCount; i++)
+                {
+                    hbSysFlushMem(&(tensors[i].sysMem[0]), HB_SYS_MEM_CACHE_INVALIDATE);
+                }
+                worker.post.Process(tensors, image_info_, mapping_, worker.results); //into this worker's scratch
+            }
+            //reorder: results reach the sink strictly in frame order
+            std::unique_lock<std::mutex> lock(draw_mtx_);
+            draw_cv_.wait(lock, [&] { return draw_seq_ == job.seq; });
+            if (!stop)
+            {
+                LatencyClock::time_point draw_start = LatencyClock::now();
+                sink_.Draw(worker.results);
+                LatencyClock::time_point draw_end = RecordStage(kStageDraw, draw_start);
+                StageLatency::Get().Record(kStageEndToEnd, job.work.capture_time, draw_end);
+                if (ctx_.debug)
+                {
+                    // fps
+                    auto delta_time = std::chrono::duration_cast<std::chrono::milliseconds>(draw_end - job.work.capture_time).count();
+                    double fps = 1000.0 / delta_time;
+                    printf("%s fps:%lf,processing time:%ld,queue depth:%zu,high water:%zu,dropped:%llu,tensor groups in use:%d/%d,high water:%d,exhausted:%llu,worker:%d\n",
+                           PostProcessor::Name(), fps, delta_time,
+                           work_ring_.size(), work_ring_.high_water(), (unsigned long long)work_ring_.dropped(),
+                           pool_.in_use(), pool_.groups(), pool_.high_water(), (unsigned long long)pool_.exhausted(), id);
+                }
+                ReportLatency(draw_end);
+                if (ctx_.bench)
+                    BenchTick(draw_end);
+            }
+            draw_seq_++;
+            lock.unlock();
+            draw_cv_.notify_all();
+            pool_.Release(job.work.lease);
+        }
+        printf("%s %s %d,finish!\n", PostProcessor::Name(), __func__, id);
+    }
+
+    /**
+     * Called in draw order,so only one thread prints at a time.
+     */
+    void ReportLatency(LatencyClock::time_point now)
+    {
+        bool requested = ctx_.latency_dump && ctx_.latency_dump->exchange(false);
+        bool periodic = ctx_.latency_report_sec && now - last_latency_report_ >= std::chrono::seconds(ctx_.latency_report_sec);
+        if (!requested && !periodic)
+            return;
+        StageLatency::Get().Dump(PostProcessor::Name());
+        last_latency_report_ = now;
+    }
+
+    /**
+     * Called in draw order. Starts measuring after the warm-up frames and
+     * stops the pipeline once the frame count or duration is reached.
+     */
+    void BenchTick(LatencyClock::time_point now)
+    {
+        drawn_frames_++;
+        if (!bench_started_)
+        {
+            if (drawn_frames_ < (uint64_t)ctx_.warmup_frames)
+                return;
+            //measure from here on,warm-up samples are discarded
+            bench_started_ = true;
+            bench_start_ = now;
+            bench_frames_ = 0;
+            ring_dropped_start_ = work_ring_.dropped();
+            pool_exhausted_start_ = pool_.exhausted();
+            capture_failures_start_ = capture_failures_.load(std::memory_order_relaxed);
+            StageLatency::Get().Reset();
+            ThreadCpuTimes::Get().MarkStart();
+            return;
+        }
+        if (bench_end_ != LatencyClock::time_point())
+            return; //already stopping
+        bench_frames_++;
+        bool done;
+        if (ctx_.bench_seconds)
+            done = now - bench_start_ >= std::chrono::seconds(ctx_.bench_seconds);
+        else
+            done = bench_frames_ >= (uint64_t)(ctx_.bench_frames ? ctx_.bench_frames : BENCH_FRAMES);
+        if (!done)
+            return;
+        bench_end_ = now;
+        ring_dropped_end_ = work_ring_.dropped();
+        pool_exhausted_end_ = pool_.exhausted();
+        capture_failures_end_ = capture_failures_.load(std::memory_order_relaxed);
+        StageLatency::Get().Freeze(); //frames still in flight or drained are not part of the window
+        ThreadCpuTimes::Get().MarkEnd();
+        *ctx_.is_stop = true;
+    }
+
+    BenchStats BenchResult()
+    {
+        BenchStats stats;
+        stats.model = PostProcessor::Name();
+        stats.mode = ctx_.mode;
+        stats.in_flight = ctx_.in_flight;
+        stats.post_workers = post_workers_;
+        stats.ring_depth = ctx_.ring_depth;
+        stats.warmup_frames = ctx_.warmup_frames;
+        if (!bench_started_)
+            return stats; //interrupted during warm-up
+        stats.completed = bench_end_ != LatencyClock::time_point();
+        if (!stats.completed)
+        {
+            //interrupted,report what was measured until now
+            bench_end_ = LatencyClock::now();
+            ring_dropped_end_ = work_ring_.dropped();
+            pool_exhausted_end_ = pool_.exhausted();
+            capture_failures_end_ = capture_failures_.load(std::memory_order_relaxed);
+        }
+        stats.frames = bench_frames_;
+        stats.seconds = std::chrono::duration<double>(bench_end_ - bench_start_).count();
+        stats.ring_dropped = ring_dropped_end_ - ring_dropped_start_;
+        stats.pool_exhausted = pool_exhausted_end_ - pool_exhausted_start_;
+        stats.capture_failures = capture_failures_end_ - capture_failures_start_;
+        return stats;
+    }
+
+    void PostThreads()
+    {
+        std::thread dispatch_thread;
+        if (post_workers_ > 1)
+            dispatch_thread = std::thread(&ModelPipeline::PostLoop, this);
+        std::thread worker_threads[BPU_MAX_POST_WORKERS];
+        for (int i = 0; i < post_workers_; i++)
+        {
+            worker_threads[i] = std::thread(&ModelPipeline::WorkerLoop, this, i);
+        }
+        for (int i = 0; i < post_workers_; i++)
+        {
+            worker_threads[i].join();
+        }
+        if (dispatch_thread.joinable())
+            dispatch_thread.join();
+        work_ring_.close(); //unblock the feed thread if we stopped first
+        pool_.Close();
+        bpu_work work;
+        while (work_ring_.try_pop(work)) //return what the feed thread queued before it saw the closed ring
+        {
+            pool_.Release(work.lease);
+        }
+    }
+
+    static constexpr int kModelInputSize = FRAME_BUFFER_SIZE(PostProcessor::kModelWidth, PostProcessor::kModelHeight);
+
+    PipelineContext &ctx_;
+    int post_workers_;
+    bpu_module *bpu_handle_ = nullptr;
+    bpu_image_info_t image_info_; //model input and display size
+    CoordMapping mapping_; //model input -> display,fixed for the pipeline
+    Source source_;
+    PreProcessor pre_;
+    Sink sink_;
+    BpuTensorPool pool_;
+    SpscRing<bpu_work> work_ring_;
+    BpuAsyncInfer async_infer_;
+    std::vector<char> frame_buffer_; //captured frame
+    PostWorker workers_[BPU_MAX_POST_WORKERS];
+    uint64_t next_seq_ = 0; //single worker only
+    uint64_t draw_seq_ = 0; //next frame to draw
+    LatencyClock::time_point last_latency_report_ = LatencyClock::now();
+    std::atomic<uint64_t> capture_failures_{0};
+    //bench,only touched in draw order and after the threads joined
+    uint64_t drawn_frames_ = 0;
+    uint64_t bench_frames_ = 0;
+    bool bench_started_ = false;
+    LatencyClock::time_point bench_start_;
+    LatencyClock::time_point bench_end_;
+    uint64_t ring_dropped_start_ = 0, ring_dropped_end_ = 0;
+    uint64_t pool_exhausted_start_ = 0, pool_exhausted_end_ = 0;
+    uint64_t capture_failures_start_ = 0, capture_failures_end_ = 0;
+    std::mutex draw_mtx_;
+    std::condition_variable draw_cv_;
+};
+
+typedef int (*PipelineRunner)(PipelineContext &ctx);
+
+/**
+ * One entry of the mode -> pipeline registration table.
+ */
+struct PipelineEntry
+{
+    int mode;
+    const char *name;
+    PipelineRunner run; //picks the source and the sink from the context
+};
+
+template <class Source, class PreProcessor, class PostProcessor, class Sink>
+int RunPipeline(PipelineContext &ctx)
+{
+    ModelPipeline<Source, PreProcessor, PostProcessor, Sink> pipeline(ctx);
+    return pipeline.Run();
+}
+
+#endif // model_pipeline
@@ -0,0 +1,54 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: greedy nms shared by every detector,boxes as structure of
+ *               arrays,neon iou and bitmask suppression
+ ***************************************************************************/
+#ifndef nms_engine
+#define nms_engine
+
+#include "detection_batch.hpp"
+
+struct NmsParams
+{
+    float iou_threshold; //a box is suppressed by a kept one above this iou
+    int top_k;           //at most top_k boxes are kept
+    bool class_agnostic; //suppress across classes too
+    int grid_min_candidates; //from this many candidates on they are bucketed in a spatial grid,0 never
+};
+
+/**
+ * n candidate boxes,element i of every array is box i.
+ */
+struct NmsBoxes
+{
+    const float *xmin;
+    const float *ymin;
+    const float *xmax;
+    const float *ymax;
+    const float *score;
+    const int *id;
+    int n;
+};
+
+/**
+ * Greedy nms:the candidates are visited by descending score (ties by index,
+ * as a stable sort would) and a candidate is kept unless a kept box of its
+ * class overlaps it by more than iou_threshold. Large candidate sets are
+ * bucketed in a spatial grid instead of being cut,a kept box is then only
+ * tested against the candidates in the cells it touches,with the same
+ * result. Scratch comes from the FrameArena of the calling thread.
+ * @param[out] keep: indices of the kept boxes,best first,room for
+ *                   min(top_k, n)
+ * @return number of kept boxes
+ */
+int NmsSelect(const NmsBoxes &boxes, const NmsParams &params, int *keep);
+
+/**
+ * NmsSelect over the detections of input,result gets the kept ones best
+ * first. The boxes are read where they are.
+ */
+void NmsBatch(const DetectionBatch &input, const NmsParams &params, DetectionBatch &result);
+
+#endif // nms_engine
@@ -0,0 +1,312 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: per model post processors for ModelPipeline,each one carries
+ *               the model input size,output tensor count and result type
+ ***************************************************************************/
+#ifndef pipeline_models
+#define pipeline_models
+
+#include <memory>
+#include <vector>
+#include "sp_bpu.h"
+#include "stage_latency.hpp"
+#include "detection_batch.hpp"
+#include "coord_mapping.hpp"
+#include "head_decode_pool.hpp"
+#include "yolov5_post_process.hpp"
+#include "yolov3_post_process.hpp"
+#include "yolov8_post_process.hpp"
+#include "yolov5_seg_post_process.hpp"
+#include "fcos_post_process.hpp"
+#include "ptq_ssd_post_process_method.hpp"
+#include "ptq_centernet_post_process_method.hpp"
+#include "ptq_centernet_maxpool_sigmoid_post_process_method.hpp"
+#include "ptq_classification_post_process_method.hpp"
+#include "ptq_unet_post_process_method.hpp"
+
+/**
+ * Yolo heads,Variant gives the input size,output and head count,decode
+ * and nms of one model. A head is one output of an anchor
+ * based model,or the class and box output pair of an anchor free one.
+ * The heads of a frame are decoded in parallel and merged in head order
+ * before nms.
+ */
+template <class Variant>
+struct YoloPostProcessor
+{
+    static constexpr int kModelWidth = Variant::kModelWidth;
+    static constexpr int kModelHeight = Variant::kModelHeight;
+    static constexpr int kOutputCount = Variant::kOutputCount;
+    static constexpr int kHeadCount = Variant::kHeadCount;
+    typedef DetectionBatch Result;
+    static const char *Name() { return Variant::Name(); }
+
+    YoloPostProcessor() : heads_(kHeadCount - 1) {}
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        LatencyClock::time_point start = LatencyClock::now();
+        results.Clear();
+        //image_info is fixed for a pipeline,so the plan is built on the first frame only
+        if (!plan_.Matches(image_info) && Variant::BuildDecodePlan(tensors, image_info, plan_) != 0)
+            return;
+        //the frame's lease owns tensors until drawing,the heads read them in place
+        auto parse = [&](int j) {
+            head_results_[j].Clear();
+            Variant::ParseTensor(tensors, plan_, j, head_results_[j]); //do post process part 1
+        };
+        heads_.Run(kHeadCount, parse);
+        parse_results_.Clear();
+        for (int j = 0; j < kHeadCount; j++)
+        {
+            parse_results_.Append(head_results_[j]);
+        }
+        start = RecordStage(kStageTensorParse, start);
+        Variant::Nms(parse_results_, results); //do post process part 2
+        mapping.Apply(results); //model input -> display,the kept boxes only
+        RecordStage(kStageNms, start);
+    }
+
+    HeadDecodePool heads_;
+    YoloDecodePlan plan_;
+    DetectionBatch head_results_[kHeadCount]; //per head,merged in head order before nms
+    DetectionBatch parse_results_;
+};
+
+struct Yolov5Variant
+{
+    static constexpr int kModelWidth = 672;
+    static constexpr int kModelHeight = 672;
+    static constexpr int kOutputCount = 3;
+    static constexpr int kHeadCount = 3;
+    static const char *Name() { return "yolov5"; }
+
+    static int BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+    {
+        return yolo5_BuildDecodePlan(tensors, image_info, plan);
+    }
+    static void ParseTensor(const hbDNNTensor *tensors, const YoloDecodePlan &plan, int layer, DetectionBatch &results)
+    {
+        ::ParseTensor(&tensors[layer], plan, layer, results);
+    }
+    static void Nms(const DetectionBatch &input, DetectionBatch &results)
+    {
+        yolo5_nms(input, nms_threshold_, nms_top_k_, results, false);
+    }
+};
+
+struct Yolov5V6V7Variant : Yolov5Variant
+{
+    static constexpr int kModelWidth = 640;
+    static constexpr int kModelHeight = 640;
+    static const char *Name() { return "yolov5_v6_v7"; }
+
+    static void Nms(const DetectionBatch &input, DetectionBatch &results)
+    {
+        yolo5_nms(input, yolov5_v6_v7_nms_threshold_, nms_top_k_, results, false);
+    }
+};
+
+struct Yolov3Variant
+{
+    static constexpr int kModelWidth = 416;
+    static constexpr int kModelHeight = 416;
+    static constexpr int kOutputCount = yolov3_output_nums_;
+    static constexpr int kHeadCount = yolov3_output_nums_;
+    static const char *Name() { return "yolov3"; }
+
+    static int BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+    {
+        return yolov3_BuildDecodePlan(tensors, image_info, plan);
+    }
+    static void ParseTensor(const hbDNNTensor *tensors, const YoloDecodePlan &plan, int layer, DetectionBatch &results)
+    {
+        yolov3_ParseTensor(&tensors[layer], plan, layer, results);
+    }
+    static void Nms(const DetectionBatch &input, DetectionBatch &results)
+    {
+        yolo3_nms(input, yolov3_nms_threshold_, yolov3_nms_top_k_, results, false);
+    }
+};
+
+//anchor free,class and box outputs per head
+struct Yolov8Variant
+{
+    static constexpr int kModelWidth = 640;
+    static constexpr int kModelHeight = 640;
+    static constexpr int kOutputCount = yolov8_output_nums_;
+    static constexpr int kHeadCount = yolov8_head_nums_;
+    static const char *Name() { return "yolov8"; }
+
+    static int BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+    {
+        return yolov8_BuildDecodePlan(tensors, image_info, plan);
+    }
+    static void ParseTensor(const hbDNNTensor *tensors, const YoloDecodePlan &plan, int layer, DetectionBatch &results)
+    {
+        yolov8_ParseTensor(tensors, plan, layer, results);
+    }
+    static void Nms(const DetectionBatch &input, DetectionBatch &results)
+    {
+        yolo5_nms(input, yolov8_nms_threshold_, yolov8_nms_top_k_, results, false);
+    }
+};
+
+//yolov5 seg,detection heads with mask coefficients,the prototype masks come last
+struct Yolov5SegVariant
+{
+    static constexpr int kModelWidth = 640;
+    static constexpr int kModelHeight = 640;
+    static constexpr int kOutputCount = yolov5_seg_output_nums_;
+    static constexpr int kHeadCount = yolov5_seg_head_nums_;
+    static const char *Name() { return "yolov5_seg"; }
+
+    static int BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+    {
+        return yolov5_seg_BuildDecodePlan(tensors, image_info, plan);
+    }
+    static void ParseTensor(const hbDNNTensor *tensors, const YoloDecodePlan &plan, int layer, DetectionBatch &results)
+    {
+        yolov5_seg_ParseTensor(&tensors[layer], plan, layer, results);
+    }
+    static void Nms(const DetectionBatch &input, DetectionBatch &results)
+    {
+        yolov5_seg_nms(input, yolov5_seg_nms_threshold_, yolov5_seg_nms_top_k_, results, false);
+    }
+};
+
+typedef YoloPostProcessor<Yolov5Variant> Yolov5PostProcessor;
+typedef YoloPostProcessor<Yolov5V6V7Variant> Yolov5V6V7PostProcessor;
+typedef YoloPostProcessor<Yolov3Variant> Yolov3PostProcessor;
+typedef YoloPostProcessor<Yolov8Variant> Yolov8PostProcessor;
+
+/**
+ * Instance segmentation,the yolov5 seg detections of YoloPostProcessor,
+ * then the masks of the boxes kept by nms only.
+ */
+struct Yolov5SegPostProcessor
+{
+    static constexpr int kModelWidth = Yolov5SegVariant::kModelWidth;
+    static constexpr int kModelHeight = Yolov5SegVariant::kModelHeight;
+    static constexpr int kOutputCount = Yolov5SegVariant::kOutputCount;
+    typedef InstanceSegmentation Result;
+    static const char *Name() { return Yolov5SegVariant::Name(); }
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        detect_.Process(tensors, image_info, mapping, results.detections);
+        LatencyClock::time_point start = LatencyClock::now();
+        yolov5_seg_BuildMasks(&tensors[yolov5_seg_head_nums_], image_info, mapping, results);
+        RecordStage(kStageMask, start);
+    }
+
+    YoloPostProcessor<Yolov5SegVariant> detect_;
+};
+
+struct FcosPostProcessor
+{
+    static constexpr int kModelWidth = 512;
+    static constexpr int kModelHeight = 512;
+    static constexpr int kOutputCount = 15;
+    typedef DetectionBatch Result;
+    static const char *Name() { return "fcos"; }
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        results.Clear();
+        fcos_post_process(tensors, results); //records tensor_parse and nms itself
+        mapping.Apply(results);
+    }
+};
+
+struct SsdPostProcessor
+{
+    static constexpr int kModelWidth = 300;
+    static constexpr int kModelHeight = 300;
+    static constexpr int kOutputCount = 12;
+    typedef DetectionBatch Result;
+    static const char *Name() { return "ssd"; }
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        results.Clear();
+        SSDPostProcess(tensors, image_info, results); //records tensor_parse and nms itself
+        mapping.Apply(results);
+    }
+};
+
+struct CenternetPostProcessor
+{
+    static constexpr int kModelWidth = 512;
+    static constexpr int kModelHeight = 512;
+    static constexpr int kOutputCount = 3;
+    typedef DetectionBatch Result;
+    static const char *Name() { return "centernet_resnet50"; }
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        LatencyClock::time_point start = LatencyClock::now();
+        results.Clear();
+        CenternetPostProcess(tensors, image_info, results); //max pool instead of nms
+        mapping.Apply(results);
+        RecordStage(kStageTensorParse, start);
+    }
+};
+
+struct CenternetMaxPoolSigmoidPostProcessor
+{
+    static constexpr int kModelWidth = 512;
+    static constexpr int kModelHeight = 512;
+    static constexpr int kOutputCount = 3;
+    typedef DetectionBatch Result;
+    static const char *Name() { return "centernet_resnet101"; }
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        LatencyClock::time_point start = LatencyClock::now();
+        results.Clear();
+        CenternetMaxPoolSigmoidPostProcess(tensors, image_info, results); //max pool instead of nms
+        mapping.Apply(results);
+        RecordStage(kStageTensorParse, start);
+    }
+};
+
+struct ClassificationPostProcessor
+{
+    static constexpr int kModelWidth = 224;
+    static constexpr int kModelHeight = 224;
+    static constexpr int kOutputCount = 1;
+    typedef std::vector<Classification> Result;
+    static const char *Name() { return "classification"; }
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        LatencyClock::time_point start = LatencyClock::now();
+        results.clear();
+        ClassificationPostProcess(tensors, image_info, results);
+        RecordStage(kStageTensorParse, start);
+    }
+};
+
+struct UnetPostProcessor
+{
+    static constexpr int kModelWidth = 2048;
+    static constexpr int kModelHeight = 1024;
+    static constexpr int kOutputCount = 1;
+    typedef Segmentation Result;
+    static const char *Name() { return "unet"; }
+
+    void Process(hbDNNTensor *tensors, bpu_image_info_t &image_info, const CoordMapping &mapping, Result &results)
+    {
+        results.num_classes = 0;
+        results.width = 0;
+        results.height = 0;
+        LatencyClock::time_point start = LatencyClock::now();
+        UnetPostProcess(tensors, image_info, results);
+        RecordStage(kStageTensorParse, start);
+    }
+};
+
+#endif // pipeline_models
@@ -0,0 +1,297 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: sources, pre processors and sinks for ModelPipeline
+ ***************************************************************************/
+#ifndef pipeline_stages
+#define pipeline_stages
+
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "model_pipeline.hpp"
+#include "detection_batch.hpp"
+#include "yolov5_seg_post_process.hpp"
+#include "ptq_classification_post_process_method.hpp"
+#include "ptq_unet_post_process_method.hpp"
+
+#define LETTERBOX_FILL_Y (114) //gray border of LetterboxPreProcessor,as the yolo letterbox
+#define LETTERBOX_FILL_UV (128)
+#define CAMERA_SENSOR_WIDTH (1920) //frame of the mipi sensors (f37,imx219,gc4663 binned),all 16:9
+#define CAMERA_SENSOR_HEIGHT (1080)
+#define MASK_HATCH_STEP (4) //DisplaySink draws every 4th row of an instance mask
+#define MASK_COLOR (0xFF00FF00)
+
+/**
+ * Mipi camera,opens one channel for bpu input and one for display.
+ */
+class CameraSource
+{
+public:
+    //every chn is the whole sensor frame scaled
+    static void FrameSize(const PipelineContext &ctx, int *width, int *height)
+    {
+        *width = CAMERA_SENSOR_WIDTH;
+        *height = CAMERA_SENSOR_HEIGHT;
+    }
+    int Open(const PipelineContext &ctx, int width, int height);
+    // 0:got a frame,>0:no frame this time,<0:fatal error
+    int GetFrame(char *buffer, int width, int height);
+    void Close();
+    void *vio() { return camera_; }
+
+private:
+    void *camera_ = nullptr;
+};
+
+/**
+ * H264 stream file,decoder -> vps,the vps scales to bpu input and display.
+ */
+class DecoderSource
+{
+public:
+    //every chn is the whole video frame scaled
+    static void FrameSize(const PipelineContext &ctx, int *width, int *height)
+    {
+        *width = ctx.video_w;
+        *height = ctx.video_h;
+    }
+    int Open(const PipelineContext &ctx, int width, int height);
+    // 0:got a frame,>0:no frame this time,<0:fatal error
+    int GetFrame(char *buffer, int width, int height);
+    void Close();
+    void *vio() { return vps_; }
+
+private:
+    int StartDecode();
+    void StopDecode();
+
+    void *vps_ = nullptr;
+    void *decoder_ = nullptr;
+    std::string stream_file_;
+    int video_w_ = 0;
+    int video_h_ = 0;
+};
+
+/**
+ * Replays nv12 frames already scaled to the capture size,without any
+ * hardware. The frames are taken to come from a source of -w x -h,the
+ * camera sensor size when not given. ctx.replay_path is one of
+ *   a regular file:frames concatenated back to back,mmap'd
+ *   a directory:one frame per file,in file name order
+ *   "-",a fifo or a device:raw frames read sequentially
+ * Frames are paced at ctx.replay_fps,or as fast as possible when 0. Files
+ * and directories start over at the end unless ctx.replay_once is set.
+ */
+class ReplaySource
+{
+public:
+    static void FrameSize(const PipelineContext &ctx, int *width, int *height)
+    {
+        bool given = ctx.video_w > 0 && ctx.video_h > 0;
+        *width = given ? ctx.video_w : CAMERA_SENSOR_WIDTH;
+        *height = given ? ctx.video_h : CAMERA_SENSOR_HEIGHT;
+    }
+    int Open(const PipelineContext &ctx, int width, int height);
+    // 0:got a frame,>0:no frame this time,<0:end of input or error
+    int GetFrame(char *buffer, int width, int height);
+    void Close();
+    void *vio() { return nullptr; }
+
+private:
+    int ReadFile(const std::string &file, char *buffer);
+    int ReadStream(char *buffer);
+
+    std::string path_;
+    size_t frame_size_ = 0;
+    bool once_ = false;
+    //regular file
+    const char *map_ = nullptr;
+    size_t map_size_ = 0;
+    //directory
+    std::vector<std::string> files_;
+    //stream
+    int fd_ = -1;
+    size_t frames_ = 0; //frames in the file or directory
+    size_t next_ = 0; //next frame to replay
+    LatencyClock::duration interval_{0};
+    LatencyClock::time_point next_time_;
+};
+
+/**
+ * Feeds the captured frame to the bpu as it is,the vio writes it straight
+ * into the bpu input tensor.
+ */
+template <int Width, int Height>
+struct PassThroughPreProcessor
+{
+    static constexpr int kOutputWidth = Width;
+    static constexpr int kOutputHeight = Height;
+
+    //the vio scales the whole display frame to the input
+    InputGeometry Init(const bpu_image_info_t &image_info, int source_width, int source_height)
+    {
+        return InputGeometry::Stretch(image_info);
+    }
+    int CaptureWidth() const { return Width; }
+    int CaptureHeight() const { return Height; }
+    bool CaptureToInput() const { return true; } //no Process() call,the frame already is the input
+
+    void Process(const char *frame, char *input) {}
+};
+
+/**
+ * Keeps the aspect ratio of the source frame: the vio scales the frame to
+ * fit Width x Height and the frame is copied into the middle of the bpu
+ * input tensor,the same bpu cost as PassThroughPreProcessor and no cpu
+ * resize. The border is filled the first time an input tensor comes by,
+ * frames never write there. Without a border,when the source already has
+ * the model aspect ratio,the vio writes straight into the input.
+ */
+template <int Width, int Height>
+class LetterboxPreProcessor
+{
+public:
+    static constexpr int kOutputWidth = Width;
+    static constexpr int kOutputHeight = Height;
+
+    InputGeometry Init(const bpu_image_info_t &image_info, int source_width, int source_height)
+    {
+        geometry_ = InputGeometry::Letterbox(image_info, source_width, source_height);
+        return geometry_;
+    }
+    int CaptureWidth() const { return geometry_.resize_width; }
+    int CaptureHeight() const { return geometry_.resize_height; }
+    bool CaptureToInput() const { return geometry_.resize_width == Width && geometry_.resize_height == Height; }
+
+    /**
+     * @param[in] frame: CaptureWidth() x CaptureHeight() nv12
+     * @param[out] input: Width x Height nv12,the bpu input tensor
+     */
+    void Process(const char *frame, char *input)
+    {
+        if (std::find(bordered_.begin(), bordered_.end(), input) == bordered_.end())
+        {
+            //the input tensors are a fixed set,so this runs once per tensor
+            memset(input, LETTERBOX_FILL_Y, Width * Height);
+            memset(input + Width * Height, LETTERBOX_FILL_UV, Width * Height / 2);
+            bordered_.push_back(input);
+        }
+        int width = geometry_.resize_width;
+        int height = geometry_.resize_height;
+        CopyPlane(frame, width, height, input + geometry_.pad_y * Width + geometry_.pad_x);
+        //interleaved uv,half the rows,the pad is even so it splits evenly
+        CopyPlane(frame + width * height, width, height / 2,
+                  input + Width * Height + geometry_.pad_y / 2 * Width + geometry_.pad_x);
+    }
+
+private:
+    static void CopyPlane(const char *src, int width, int height, char *dst)
+    {
+        if (width == Width)
+        {
+            memcpy(dst, src, width * height); //border above and below only,one block
+            return;
+        }
+        for (int i = 0; i < height; i++)
+        {
+            memcpy(dst + i * Width, src + i * width, width);
+        }
+    }
+
+    InputGeometry geometry_;
+    std::vector<char *> bordered_; //input tensors whose border is filled
+};
+
+/**
+ * Captures SrcWidth x SrcHeight and resizes the nv12 frame on the cpu into
+ * the bpu input tensor,for model inputs the vio channel can not produce
+ * directly.
+ */
+template <int SrcWidth, int SrcHeight, int DstWidth, int DstHeight>
+class Nv12ResizePreProcessor
+{
+public:
+    static constexpr int kOutputWidth = DstWidth;
+    static constexpr int kOutputHeight = DstHeight;
+
+    //the vio and the resize both scale the whole frame
+    InputGeometry Init(const bpu_image_info_t &image_info, int source_width, int source_height)
+    {
+        return InputGeometry::Stretch(image_info);
+    }
+    int CaptureWidth() const { return SrcWidth; }
+    int CaptureHeight() const { return SrcHeight; }
+    bool CaptureToInput() const { return false; }
+
+    /**
+     * @param[in] frame: SrcWidth x SrcHeight nv12
+     * @param[out] input: DstWidth x DstHeight nv12,the bpu input tensor
+     */
+    void Process(const char *frame, char *input)
+    {
+        // Y and interleaved UV planes are resized separately,straight into the input tensor
+        cv::Mat src_y(SrcHeight, SrcWidth, CV_8UC1, const_cast<char *>(frame));
+        cv::Mat src_uv(SrcHeight / 2, SrcWidth / 2, CV_8UC2, const_cast<char *>(frame) + SrcWidth * SrcHeight);
+        cv::Mat dst_y(DstHeight, DstWidth, CV_8UC1, input);
+        cv::Mat dst_uv(DstHeight / 2, DstWidth / 2, CV_8UC2, input + DstWidth * DstHeight);
+        cv::resize(src_y, dst_y, cv::Size(DstWidth, DstHeight));
+        cv::resize(src_uv, dst_uv, cv::Size(DstWidth / 2, DstHeight / 2));
+    }
+};
+
+/**
+ * Video on display chn 1 (bound to the source),results drawn on chn 3.
+ */
+class DisplaySink
+{
+public:
+    int Open(const PipelineContext &ctx, void *vio);
+    void Close(void *vio);
+
+    void Draw(const DetectionBatch &results);
+    void Draw(const std::vector<Classification> &results);
+    void Draw(const Segmentation &results);
+    void Draw(const InstanceSegmentation &results);
+
+private:
+    void *display_ = nullptr;
+};
+
+/**
+ * Headless sink for --bench,opens no display and discards the results.
+ */
+struct NullSink
+{
+    int Open(const PipelineContext &ctx, void *vio) { return 0; }
+    void Close(void *vio) {}
+
+    template <class Result>
+    void Draw(const Result &results) {}
+};
+
+/**
+ * Run the model on its own Source,or on a ReplaySource when ctx.replay_path
+ * is set,drawing on the display,or discarding results in bench mode.
+ */
+template <class Source, class PreProcessor, class PostProcessor>
+int RunModel(PipelineContext &ctx)
+{
+    if (!ctx.replay_path.empty())
+        return ctx.bench ? RunPipeline<ReplaySource, PreProcessor, PostProcessor, NullSink>(ctx)
+                         : RunPipeline<ReplaySource, PreProcessor, PostProcessor, DisplaySink>(ctx);
+    return ctx.bench ? RunPipeline<Source, PreProcessor, PostProcessor, NullSink>(ctx)
+                     : RunPipeline<Source, PreProcessor, PostProcessor, DisplaySink>(ctx);
+}
+
+template <class Source, class PreProcessor, class PostProcessor>
+constexpr PipelineEntry MakePipelineEntry(int mode, const char *name)
+{
+    return {mode, name, RunModel<Source, PreProcessor, PostProcessor>};
+}
+
+#endif // pipeline_stages
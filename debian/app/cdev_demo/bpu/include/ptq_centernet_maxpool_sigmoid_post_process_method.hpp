@@ -10,7 +10,9 @@
 #include <iomanip>
 #include <algorithm>
 #include <queue>
+#ifdef __ARM_NEON
 #include <arm_neon.h>
+#endif
 #include <cassert>
 #include "sp_bpu.h"
 #include <opencv2/opencv.hpp>
@@ -25,7 +27,7 @@ struct PTQCenternetMaxPoolSigmoidConfig {
   std::vector<std::string> class_names;
 };
 
-extern int CenternetMaxPoolSigmoidPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std::vector<Detection> &centernet_det_restuls, bool is_pad_resize);
+extern int CenternetMaxPoolSigmoidPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, DetectionBatch &centernet_det_restuls);
 
 
 #endif  // ptq_centernet_maxpool_sigmoid_post_process_method
@@ -10,7 +10,9 @@
 #include <iomanip>
 #include <algorithm>
 #include <queue>
+#ifdef __ARM_NEON
 #include <arm_neon.h>
+#endif
 #include <cassert>
 #include "sp_bpu.h"
 #include <opencv2/opencv.hpp>
@@ -26,6 +28,6 @@ struct PTQCenternetConfig {
 };
 
 
-extern int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std::vector<Detection> &centernet_det_restuls, bool is_pad_resize);
+extern int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, DetectionBatch &centernet_det_restuls);
 
 #endif
@@ -10,7 +10,9 @@
 #include <iomanip>
 #include <algorithm>
 #include <queue>
+#ifdef __ARM_NEON
 #include <arm_neon.h>
+#endif
 #include <cassert>
 #include "sp_bpu.h"
 #include <opencv2/opencv.hpp>
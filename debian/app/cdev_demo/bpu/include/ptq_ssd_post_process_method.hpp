@@ -10,7 +10,9 @@
 #include <iomanip>
 #include <algorithm>
 #include <queue>
+#ifdef __ARM_NEON
 #include <arm_neon.h>
+#endif
 #include <cassert>
 #include "sp_bpu.h"
 #include <opencv2/opencv.hpp>
@@ -73,7 +75,7 @@ extern SSDConfig default_ssd_config;
 
 
 extern int SSDPostProcess(hbDNNTensor *tensors,
-                bpu_image_info_t &image_info, std::vector<Detection> &ssd_det_restuls);
+                bpu_image_info_t &image_info, DetectionBatch &ssd_det_restuls);
 
 int SsdAnchors(std::vector<Anchor> &anchors,
                 int layer,
@@ -82,21 +84,21 @@ int SsdAnchors(std::vector<Anchor> &anchors,
 
 int GetBboxAndScores(hbDNNTensor *c_tensor,
                       hbDNNTensor *bbox_tensor,
-                      std::vector<Detection> &dets,
+                      DetectionBatch &dets,
                       std::vector<Anchor> &anchors,
                       int class_num,
                       bpu_image_info_t &image_info);
 
 int GetBboxAndScoresQuantiNONE(hbDNNTensor *c_tensor,
                                 hbDNNTensor *bbox_tensor,
-                                std::vector<Detection> &dets,
+                                DetectionBatch &dets,
                                 std::vector<Anchor> &anchors,
                                 int class_num,
                                 bpu_image_info_t &image_info);
 
 int GetBboxAndScoresQuantiSCALE(hbDNNTensor *c_tensor,
                                 hbDNNTensor *bbox_tensor,
-                                std::vector<Detection> &dets,
+                                DetectionBatch &dets,
                                 std::vector<Anchor> &anchors,
                                 int class_num,
                                 bpu_image_info_t &image_info);
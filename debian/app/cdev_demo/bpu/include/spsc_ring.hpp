@@ -0,0 +1,285 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: bounded single-producer/single-consumer ring used between
+ *               the bpu feed thread and the post processing thread
+ ***************************************************************************/
+#ifndef spsc_ring
+#define spsc_ring
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#define SPSC_CACHE_LINE_SIZE 64
+#define SPSC_SPIN_COUNT 128
+
+/**
+ * What push() does when the ring is full.
+ */
+enum class RingOverflowPolicy {
+  kBlock,       // wait until the consumer frees a slot
+  kDropOldest,  // evict the oldest queued item and queue the new one
+  kDropNewest,  // discard the item being pushed
+};
+
+enum class RingPushResult {
+  kPushed,   // item queued
+  kEvicted,  // item queued, the oldest item was evicted (kDropOldest)
+  kDropped,  // item discarded (kDropNewest)
+  kClosed,   // ring closed, item discarded
+};
+
+/**
+ * Parse "block", "drop_oldest" or "drop_newest".
+ * @param[in] name: policy name
+ * @param[out] policy: parsed policy
+ * @return true if name is a known policy
+ */
+inline bool ParseRingOverflowPolicy(const std::string &name,
+                                    RingOverflowPolicy &policy) {
+  if (name == "block") {
+    policy = RingOverflowPolicy::kBlock;
+  } else if (name == "drop_oldest") {
+    policy = RingOverflowPolicy::kDropOldest;
+  } else if (name == "drop_newest") {
+    policy = RingOverflowPolicy::kDropNewest;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Bounded lock-free ring for exactly one producer thread and one consumer
+ * thread. Head and tail live on separate cache lines. Both sides spin for a
+ * short while and then sleep on a condition variable, so an idle post
+ * processing thread no longer burns a core.
+ *
+ * With kDropOldest the producer advances the head itself, so the consumer
+ * claims items with a CAS as well. The ring keeps one spare slot so that the
+ * slot being refilled is never the one a consumer is claiming; a consumer
+ * whose claim raced with an eviction simply retries. T must be trivially
+ * copyable for this reason.
+ */
+template <typename T>
+class SpscRing {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SpscRing items must be trivially copyable");
+
+ public:
+  explicit SpscRing(size_t capacity,
+                    RingOverflowPolicy policy = RingOverflowPolicy::kBlock)
+      : capacity_(capacity), slots_(capacity + 1), policy_(policy) {}
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  /**
+   * Must be called before the ring is shared between threads.
+   */
+  void set_overflow_policy(RingOverflowPolicy policy) { policy_ = policy; }
+  RingOverflowPolicy overflow_policy() const { return policy_; }
+
+  /**
+   * Producer side.
+   * @param[in] item: item to queue
+   * @param[out] evicted: receives the evicted item when kEvicted is returned,
+   *                      so its resources can be recycled. May be nullptr.
+   */
+  RingPushResult push(const T &item, T *evicted = nullptr) {
+    if (closed_.load(std::memory_order_acquire)) {
+      return RingPushResult::kClosed;
+    }
+    RingPushResult result = RingPushResult::kPushed;
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    int spin = 0;
+    for (;;) {
+      size_t head = head_.load(std::memory_order_acquire);
+      if (tail - head < capacity_) {
+        break;
+      }
+      if (policy_ == RingOverflowPolicy::kDropNewest) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return RingPushResult::kDropped;
+      }
+      if (policy_ == RingOverflowPolicy::kDropOldest) {
+        T oldest = slots_[head % slots_.size()];
+        if (head_.compare_exchange_strong(head, head + 1,
+                                          std::memory_order_acq_rel)) {
+          if (evicted) {
+            *evicted = oldest;
+          }
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+          result = RingPushResult::kEvicted;
+          break;
+        }
+        continue;
+      }
+      // kBlock
+      if (spin < SPSC_SPIN_COUNT) {
+        spin++;
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mtx_);
+      producer_waiting_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (tail - head_.load(std::memory_order_acquire) >= capacity_ &&
+             !closed_.load(std::memory_order_acquire)) {
+        not_full_cv_.wait(lock);
+      }
+      producer_waiting_.store(false, std::memory_order_relaxed);
+      if (closed_.load(std::memory_order_acquire)) {
+        return RingPushResult::kClosed;
+      }
+    }
+
+    slots_[tail % slots_.size()] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+
+    size_t depth = tail + 1 - head_.load(std::memory_order_relaxed);
+    if (depth > high_water_.load(std::memory_order_relaxed)) {
+      high_water_.store(depth, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_waiting_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mtx_);
+      not_empty_cv_.notify_one();
+    }
+    return result;
+  }
+
+  /**
+   * Consumer side, non blocking.
+   * @return false if the ring is empty
+   */
+  bool try_pop(T &item) {
+    for (;;) {
+      size_t head = head_.load(std::memory_order_acquire);
+      if (head == tail_.load(std::memory_order_acquire)) {
+        return false;
+      }
+      T value = slots_[head % slots_.size()];
+      if (policy_ == RingOverflowPolicy::kDropOldest) {
+        if (!head_.compare_exchange_strong(head, head + 1,
+                                           std::memory_order_acq_rel)) {
+          continue;  // the producer evicted this item meanwhile
+        }
+      } else {
+        head_.store(head + 1, std::memory_order_release);
+      }
+      item = value;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (producer_waiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        not_full_cv_.notify_one();
+      }
+      return true;
+    }
+  }
+
+  /**
+   * Consumer side, blocks until an item arrives.
+   * @return false once the ring is closed and drained
+   */
+  bool pop(T &item) { return pop_for(item, -1); }
+
+  /**
+   * Consumer side, blocks for at most timeout_ms (forever if negative).
+   * @return false on timeout, or once the ring is closed and drained
+   */
+  bool pop_for(T &item, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+    int spin = 0;
+    for (;;) {
+      if (try_pop(item)) {
+        return true;
+      }
+      if (closed_.load(std::memory_order_acquire)) {
+        return try_pop(item);
+      }
+      if (spin < SPSC_SPIN_COUNT) {
+        spin++;
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mtx_);
+      consumer_waiting_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      bool timed_out = false;
+      while (empty() && !closed_.load(std::memory_order_acquire)) {
+        if (timeout_ms < 0) {
+          not_empty_cv_.wait(lock);
+        } else if (not_empty_cv_.wait_until(lock, deadline) ==
+                   std::cv_status::timeout) {
+          timed_out = true;
+          break;
+        }
+      }
+      consumer_waiting_.store(false, std::memory_order_relaxed);
+      if (timed_out) {
+        lock.unlock();
+        return try_pop(item);
+      }
+    }
+  }
+
+  /**
+   * Wake both sides up. Pending items can still be popped; push() fails.
+   */
+  void close() {
+    closed_.store(true, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(mtx_);
+    not_empty_cv_.notify_all();
+    not_full_cv_.notify_all();
+  }
+
+  bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+  bool empty() const { return size() == 0; }
+
+  size_t size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  // items discarded by kDropOldest or kDropNewest
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // deepest queue observed by the producer
+  size_t high_water() const {
+    return high_water_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<bool> consumer_waiting_{false};
+  std::atomic<bool> producer_waiting_{false};
+  std::atomic<bool> closed_{false};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<size_t> high_water_{0};
+
+  const size_t capacity_;
+  std::vector<T> slots_;
+  RingOverflowPolicy policy_;
+
+  std::mutex mtx_;
+  std::condition_variable not_empty_cv_;
+  std::condition_variable not_full_cv_;
+};
+
+#endif  // spsc_ring
@@ -0,0 +1,112 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: per stage latency histograms of the bpu sample pipeline
+ ***************************************************************************/
+#ifndef stage_latency
+#define stage_latency
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+typedef std::chrono::steady_clock LatencyClock; //monotonic,not affected by time changes
+
+enum LatencyStage
+{
+    kStageCapture,     //source GetFrame
+    kStagePreprocess,  //pre processor,when the frame is not captured into the input tensor
+    kStageBpuSubmit,   //cache clean + hbDNNInfer
+    kStageBpuDone,     //submit returned -> hbDNNWaitTaskDone returned
+    kStageTensorParse, //output tensors -> candidate boxes
+    kStageNms,         //candidate boxes -> results
+    kStageMask,        //kept boxes -> instance masks
+    kStageDraw,        //sink Draw
+    kStageEndToEnd,    //capture start -> draw done
+    kStageCount
+};
+
+/**
+ * Log-linear histogram of microseconds (HDR style): every power of two is
+ * split into 2^kSubBucketBits linear buckets, so any value is kept with a
+ * relative error below 1/2^kSubBucketBits. Recording is a few relaxed
+ * atomic adds, safe from any thread.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    void Record(uint64_t us);
+
+    /**
+     * @param[in] quantile: 0~1
+     * @return upper bound of the bucket holding the quantile,0 if empty
+     */
+    uint64_t Percentile(double quantile) const;
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+    void Reset();
+
+private:
+    static int BucketIndex(uint64_t us);
+    static uint64_t BucketUpperBound(int index);
+
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * One histogram per LatencyStage,shared by every thread of the pipeline.
+ */
+class StageLatency
+{
+public:
+    static StageLatency &Get();
+
+    void Record(LatencyStage stage, LatencyClock::time_point start, LatencyClock::time_point end);
+
+    /**
+     * Print count,mean,p50/p90/p99 and max of every stage that has samples.
+     */
+    void Dump(const char *title);
+
+    /**
+     * Empty every histogram,recording goes on or starts again after Freeze().
+     */
+    void Reset();
+
+    /**
+     * Ignore Record() from now on,so the histograms keep one measured window.
+     */
+    void Freeze() { frozen_.store(true, std::memory_order_relaxed); }
+
+    const LatencyHistogram &histogram(LatencyStage stage) const { return histograms_[stage]; }
+
+    static const char *StageName(LatencyStage stage);
+
+private:
+    LatencyHistogram histograms_[kStageCount];
+    std::atomic<bool> frozen_{false};
+};
+
+/**
+ * Shorthand for StageLatency::Get().Record(stage, start, now()).
+ * @return now(),handy as the start of the next stage
+ */
+inline LatencyClock::time_point RecordStage(LatencyStage stage, LatencyClock::time_point start)
+{
+    LatencyClock::time_point now = LatencyClock::now();
+    StageLatency::Get().Record(stage, start, now);
+    return now;
+}
+
+#endif // stage_latency
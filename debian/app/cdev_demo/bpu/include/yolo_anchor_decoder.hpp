@@ -0,0 +1,83 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: one decoder for the anchor based yolo heads (yolov3,yolov5
+ *               s/x,yolov5 v6/v7),specialized at compile time per variant
+ ***************************************************************************/
+#ifndef yolo_anchor_decoder
+#define yolo_anchor_decoder
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "sp_bpu.h"
+#include "bpu_kernels.hpp"
+#include "detection_batch.hpp"
+#include "yolo_decode_plan.hpp"
+
+/**
+ * Strides and anchors of one variant,strides[i] and anchors_table[i]
+ * belong to output head i. Every anchor predicts box,objectness,class_num
+ * class logits and mask_dim mask coefficients.
+ */
+struct YoloAnchorConfig
+{
+    std::vector<int> strides;
+    std::vector<std::vector<std::pair<double, double>>> anchors_table;
+    int class_num;
+    std::vector<std::string> class_names;
+    int mask_dim; //0 for detection only variants
+};
+
+/**
+ * Box policies,how the activated xy/wh outputs become a box. Size() is the
+ * wh activation,the constant factors are folded into the plan by Coding().
+ */
+struct Yolov5BoxPolicy
+{
+    //center = (sigmoid * 2 - 0.5 + cell) * stride,size = (sigmoid * 2)^2 * anchor
+    static YoloBoxCoding Coding() { return {2.0f, -0.5f, 4.0f, false}; }
+    static float Size(float logit)
+    {
+        float s = Sigmoid<KernelAccuracy::kExact>(logit);
+        return s * s;
+    }
+};
+
+struct Yolov3BoxPolicy
+{
+    //center = (sigmoid + cell) * stride,size = exp * anchor * stride
+    static YoloBoxCoding Coding() { return {1.0f, 0.0f, 1.0f, true}; }
+    static float Size(float logit) { return Exp<KernelAccuracy::kExact>(logit); }
+};
+
+/**
+ * Decoder of one variant. Each head is decoded in two phases:an objectness
+ * scan against the score threshold in the logit domain,then the full
+ * decode of the few anchors that passed. Float outputs and SCALE quantized
+ * int8/int16/int32 outputs are read in place in NHWC or NCHW,quantized
+ * ones are scanned in the integer domain. Box policy,element type and
+ * layout are template parameters,the inner loops do not branch on them.
+ * Instantiated in yolo_anchor_decoder.cpp for the variants in use.
+ */
+template <class BoxPolicy>
+struct AnchorYoloDecoder
+{
+    /**
+     * Decode plan of the heads in tensors for image_info.
+     * @return 0 if success
+     */
+    static int BuildPlan(const YoloAnchorConfig &config, const hbDNNTensor *tensors,
+                         const bpu_image_info_t &image_info, YoloDecodePlan &plan);
+
+    /**
+     * Append the boxes of head layer above score_threshold to results,in
+     * model input pixels,with their config.mask_dim mask coefficients as
+     * payload. Scratch comes from the FrameArena of the calling thread.
+     */
+    static void ParseTensor(const YoloAnchorConfig &config, float score_threshold, const hbDNNTensor *tensor,
+                            const YoloDecodePlan &plan, int layer, DetectionBatch &results);
+};
+
+#endif // yolo_anchor_decoder
@@ -0,0 +1,127 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: per model decode tables of anchor based yolo heads,built
+ *               once per resolution so the box decode is multiply-adds only
+ ***************************************************************************/
+#ifndef yolo_decode_plan
+#define yolo_decode_plan
+
+#include <utility>
+#include <vector>
+#include "sp_bpu.h"
+
+/**
+ * One output head. Boxes are decoded in model input pixels,the stride and
+ * the box coding are already folded into every table:
+ *   center_x = grid_x[w] + xy_gain_x * dx
+ *   half_w   = anchor_half_w[k] * sw
+ * with dx/sw the activated outputs of the head (sigmoid,sigmoid^2 or exp).
+ */
+struct YoloDecodeLayer
+{
+    int height;
+    int width;
+    int anchor_num;
+    float xy_gain_x;                  //model pixels per unit of dx
+    float xy_gain_y;
+    std::vector<float> grid_x;        //width entries
+    std::vector<float> grid_y;        //height entries
+    std::vector<float> anchor_half_w; //anchor_num entries
+    std::vector<float> anchor_half_h;
+};
+
+/**
+ * In place view of one output head,element steps of (h,w,c). kPlanar is
+ * NCHW,every channel is a plane with contiguous w,else NHWC with the
+ * channels of a cell contiguous. The contiguous step is a compile time 1,
+ * the others come from the tensor,so padded outputs need no repack.
+ */
+template <bool kPlanar>
+struct HeadView
+{
+    int h_step;
+    int w_step;
+    int c_step;
+
+    /**
+     * Steps from properties.stride,or from the aligned shape when the
+     * toolchain left stride empty.
+     * @return false if the tensor is not laid out as kPlanar says
+     */
+    bool Init(const hbDNNTensorProperties &properties, int element_size)
+    {
+        if (properties.tensorLayout != (kPlanar ? HB_DNN_LAYOUT_NCHW : HB_DNN_LAYOUT_NHWC))
+            return false;
+        int steps[4];
+        if (properties.stride[3] > 0)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                steps[i] = properties.stride[i] / element_size;
+            }
+        }
+        else
+        {
+            steps[3] = 1;
+            for (int i = 2; i >= 0; i--)
+            {
+                steps[i] = steps[i + 1] * properties.alignedShape.dimensionSize[i + 1];
+            }
+        }
+        if (steps[3] != 1)
+            return false;
+        h_step = kPlanar ? steps[2] : steps[1];
+        w_step = kPlanar ? 1 : steps[2];
+        c_step = kPlanar ? steps[1] : 1;
+        return true;
+    }
+
+    int WStep() const { return kPlanar ? 1 : w_step; }
+    int CStep() const { return kPlanar ? c_step : 1; }
+    int Offset(int h, int w, int c) const { return h * h_step + w * WStep() + c * CStep(); }
+};
+
+/**
+ * Decode plan of one model at one input resolution,the display size does
+ * not matter,CoordMapping takes the boxes there after nms.
+ */
+struct YoloDecodePlan
+{
+    bpu_image_info_t image_info; //what the tables were built for
+    std::vector<YoloDecodeLayer> layers;
+
+    bool Matches(const bpu_image_info_t &info) const
+    {
+        return !layers.empty() && info.m_model_w == image_info.m_model_w && info.m_model_h == image_info.m_model_h;
+    }
+};
+
+/**
+ * How a head maps its outputs to model pixels,
+ *   center = (dx * xy_scale + xy_offset + cell) * stride
+ *   size   = sw * anchor * size_scale (* stride for anchors in grid units)
+ */
+struct YoloBoxCoding
+{
+    float xy_scale;
+    float xy_offset;
+    float size_scale;
+    bool anchors_in_grid; //anchors_table is in cells instead of model pixels
+};
+
+/**
+ * Build the plan of one model,layer i uses strides[i],anchors_table[i]
+ * and a heights[i] x widths[i] grid.
+ * @return 0 if success
+ */
+int BuildYoloDecodePlan(const bpu_image_info_t &image_info,
+                        const std::vector<int> &strides,
+                        const std::vector<std::vector<std::pair<double, double>>> &anchors_table,
+                        const std::vector<int> &heights,
+                        const std::vector<int> &widths,
+                        const YoloBoxCoding &coding,
+                        YoloDecodePlan &plan);
+
+#endif // yolo_decode_plan
@@ -0,0 +1,58 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: decoder of the anchor free yolo heads (yolov8 style),
+ *               per class sigmoid scores and distribution focal loss boxes
+ ***************************************************************************/
+#ifndef yolo_dfl_decoder
+#define yolo_dfl_decoder
+
+#include <string>
+#include <vector>
+#include "sp_bpu.h"
+#include "bpu_kernels.hpp"
+#include "detection_batch.hpp"
+#include "yolo_decode_plan.hpp"
+
+/**
+ * Strides of one anchor free model. Head i has two outputs,tensors[2 * i]
+ * with class_num class logits per cell and tensors[2 * i + 1] with
+ * 4 * reg_max box bins per cell (left,top,right,bottom distances).
+ */
+struct YoloDflConfig
+{
+    std::vector<int> strides;
+    int reg_max;
+    int class_num;
+    std::vector<std::string> class_names;
+};
+
+/**
+ * Decoder of one anchor free model. Each head is decoded in two phases:the
+ * best class logit of every cell against the score threshold in the logit
+ * domain,then the box bins of the few cells that passed,each side the
+ * expectation of a softmax over reg_max bins. Float and SCALE quantized
+ * int8/int16/int32 outputs are read in place in NHWC or NCHW,the class and
+ * box outputs of a head may differ in type and layout.
+ */
+struct DflYoloDecoder
+{
+    /**
+     * Decode plan of the heads in tensors for image_info,checks the output
+     * shapes against config.
+     * @return 0 if success
+     */
+    static int BuildPlan(const YoloDflConfig &config, const hbDNNTensor *tensors,
+                         const bpu_image_info_t &image_info, YoloDecodePlan &plan);
+
+    /**
+     * Append the boxes of head layer above score_threshold to results,in
+     * model input pixels. tensors is the first output of the model.
+     * Scratch comes from the FrameArena of the calling thread.
+     */
+    static void ParseHead(const YoloDflConfig &config, float score_threshold, const hbDNNTensor *tensors,
+                          const YoloDecodePlan &plan, int layer, DetectionBatch &results);
+};
+
+#endif // yolo_dfl_decoder
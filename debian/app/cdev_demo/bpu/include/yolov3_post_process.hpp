@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <vector>
 #include "sp_bpu.h"
+#include "detection_batch.hpp"
+#include "yolo_anchor_decoder.hpp"
 #include "yolov3_post_process.hpp"
 #include <opencv2/opencv.hpp>
 
@@ -17,75 +19,33 @@ typedef struct
     int height_offset;
 } yolov3_ori_image;
 
-struct PTQYolo3Config
-{
-    std::vector<int> strides;
-    std::vector<std::vector<std::pair<double, double>>> anchors_table;
-    int class_num;
-    std::vector<std::string> class_names;
-    std::vector<std::vector<float>> dequantize_scale;
-};
-
-
-template <class ForwardIterator>
-inline size_t yolov3_argmax(ForwardIterator first, ForwardIterator last)
-{
-    return std::distance(first, std::max_element(first, last));
-}
-
-struct YoloV3Result
-{
-    // 目标类别ID
-    int id;
-    // 目标检测框
-    float xmin;
-    float ymin;
-    float xmax;
-    float ymax;
-    // 检测结果的置信度
-    float score;
-    // 目标类别
-    std::string class_name;
-
-    YoloV3Result(int id_,
-                 float xmin_,
-                 float ymin_,
-                 float xmax_,
-                 float ymax_,
-                 float score_,
-                 std::string class_name_)
-        : id(id_),
-          xmin(xmin_),
-          ymin(ymin_),
-          xmax(xmax_),
-          ymax(ymax_),
-          score(score_),
-          class_name(class_name_) {}
-
-    friend bool operator>(const YoloV3Result &lhs, const YoloV3Result &rhs)
-    {
-        return (lhs.score > rhs.score);
-    }
-};
+typedef YoloAnchorConfig PTQYolo3Config;
 
 const float yolov3_score_threshold_ = 0.3;
 const float yolov3_nms_threshold_ = 0.45;
 const int yolov3_nms_top_k_ = 500;
+const int yolov3_nms_grid_candidates_ = 512;
 const int yolov3_output_nums_ = 3;
 
 
-extern void yolov3_ParseTensor(std::shared_ptr<hbDNNTensor> tensor,
+// boxes come out in model input pixels through plan
+extern void yolov3_ParseTensor(const hbDNNTensor *tensor,
+                 const YoloDecodePlan &plan,
                  int layer,
-                 std::vector<YoloV3Result> &results, bpu_image_info_t &image_info);
+                 DetectionBatch &results);
 
-extern void yolo3_nms(std::vector<YoloV3Result> &input,
+// build the decode plan of the yolov3 heads in tensors for image_info,
+// return 0 if success
+extern int yolov3_BuildDecodePlan(const hbDNNTensor *tensors,
+                 const bpu_image_info_t &image_info,
+                 YoloDecodePlan &plan);
+
+extern void yolo3_nms(const DetectionBatch &input,
                float iou_threshold,
                int top_k,
-               std::vector<std::shared_ptr<YoloV3Result>> &result,
+               DetectionBatch &result,
                bool suppress);
 
-extern int yolov3_get_tensor_hw(std::shared_ptr<hbDNNTensor> tensor, int *height, int *width);
-
 //extern void get_ori_image(uint8_t *addr, int ori_height, int ori_width, int model_height, int model_width, std::vector<std::shared_ptr<YoloV3Result>> results);
 
 #endif
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <vector>
 #include "sp_bpu.h"
+#include "detection_batch.hpp"
+#include "yolo_anchor_decoder.hpp"
 #include "yolov5_post_process.hpp"
 #include <opencv2/opencv.hpp>
 
@@ -17,76 +19,39 @@ typedef struct
     int height_offset;
 } ori_image;
 
-struct PTQYolo5Config
-{
-    std::vector<int> strides;
-    std::vector<std::vector<std::pair<double, double>>> anchors_table;
-    int class_num;
-    std::vector<std::string> class_names;
-    std::vector<std::vector<float>> dequantize_scale;
-};
-
-
-
-
-template <class ForwardIterator>
-inline size_t argmax(ForwardIterator first, ForwardIterator last)
-{
-    return std::distance(first, std::max_element(first, last));
-}
-
-struct YoloV5Result
-{
-    // 目标类别ID
-    int id;
-    // 目标检测框
-    float xmin;
-    float ymin;
-    float xmax;
-    float ymax;
-    // 检测结果的置信度
-    float score;
-    // 目标类别
-    std::string class_name;
-
-    YoloV5Result(int id_,
-                 float xmin_,
-                 float ymin_,
-                 float xmax_,
-                 float ymax_,
-                 float score_,
-                 std::string class_name_)
-        : id(id_),
-          xmin(xmin_),
-          ymin(ymin_),
-          xmax(xmax_),
-          ymax(ymax_),
-          score(score_),
-          class_name(class_name_) {}
-
-    friend bool operator>(const YoloV5Result &lhs, const YoloV5Result &rhs)
-    {
-        return (lhs.score > rhs.score);
-    }
-};
+typedef YoloAnchorConfig PTQYolo5Config;
 
 const float score_threshold_ = 0.4;
 const float nms_threshold_ = 0.5;
 const int nms_top_k_ = 5000;
-
-
-extern void ParseTensor(std::shared_ptr<hbDNNTensor> tensor,
+//from this many candidates on nms buckets them in a spatial grid,keeps its
+//cost near linear in crowded frames without dropping candidates
+const int nms_grid_candidates_ = 512;
+//yolov5 v6/v7 640x640 exports,same heads and anchors as yolov5s/x
+const float yolov5_v6_v7_nms_threshold_ = 0.45;
+
+
+/**
+ * Decode one output layer with AnchorYoloDecoder and the yolov5 box
+ * coding,boxes come out in model input pixels through plan.
+ */
+extern void ParseTensor(const hbDNNTensor *tensor,
+                 const YoloDecodePlan &plan,
                  int layer,
-                 std::vector<YoloV5Result> &results,bpu_image_info_t &image_info);
+                 DetectionBatch &results);
+
+/**
+ * Build the decode plan of the yolov5 heads in tensors for image_info.
+ * @return 0 if success
+ */
+extern int yolo5_BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan);
 
-extern void yolo5_nms(std::vector<YoloV5Result> &input,
+extern void yolo5_nms(const DetectionBatch &input,
                float iou_threshold,
                int top_k,
-               std::vector<std::shared_ptr<YoloV5Result>> &result,
+               DetectionBatch &result,
                bool suppress);
 
-extern int get_tensor_hw(std::shared_ptr<hbDNNTensor> tensor, int *height, int *width);
-
 //extern void get_ori_image(uint8_t *addr, int ori_height, int ori_width, int model_height, int model_width, std::vector<std::shared_ptr<YoloV5Result>> results);
 
 #endif
\ No newline at end of file
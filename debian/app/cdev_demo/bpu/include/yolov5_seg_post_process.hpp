@@ -0,0 +1,82 @@
+#ifndef yolov5_seg_post
+#define yolov5_seg_post
+
+#include <stdint.h>
+#include <vector>
+#include "sp_bpu.h"
+#include "detection_batch.hpp"
+#include "coord_mapping.hpp"
+#include "yolo_anchor_decoder.hpp"
+
+typedef YoloAnchorConfig PTQYolo5SegConfig;
+
+// prototype masks,mask coefficients per anchor
+const int yolov5_seg_mask_dim_ = 32;
+const float yolov5_seg_score_threshold_ = 0.4;
+const float yolov5_seg_nms_threshold_ = 0.45;
+const int yolov5_seg_nms_top_k_ = 300;
+const int yolov5_seg_nms_grid_candidates_ = 512;
+const int yolov5_seg_head_nums_ = 3;
+// the three heads,then the prototype masks
+const int yolov5_seg_output_nums_ = yolov5_seg_head_nums_ + 1;
+
+
+/**
+ * Mask of one detection in display coordinates,width x height bytes (1
+ * inside the object,0 outside) at InstanceSegmentation::pixels + offset,
+ * covering the display rect starting at x,y.
+ */
+struct InstanceMask
+{
+    int x;
+    int y;
+    int width;
+    int height;
+    size_t offset;
+};
+
+struct InstanceSegmentation
+{
+    DetectionBatch detections;         // with the mask coefficients as payload
+    std::vector<InstanceMask> masks;   // masks[i] belongs to detection i
+    std::vector<uint8_t> pixels;       // every mask,back to back
+};
+
+
+/**
+ * Decode one output head with AnchorYoloDecoder and the yolov5 box coding,
+ * boxes come out in model input pixels through plan,with their mask
+ * coefficients.
+ */
+extern void yolov5_seg_ParseTensor(const hbDNNTensor *tensor,
+                 const YoloDecodePlan &plan,
+                 int layer,
+                 DetectionBatch &results);
+
+/**
+ * Build the decode plan of the yolov5 seg heads in tensors for image_info.
+ * @return 0 if success
+ */
+extern int yolov5_seg_BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan);
+
+extern void yolov5_seg_nms(const DetectionBatch &input,
+               float iou_threshold,
+               int top_k,
+               DetectionBatch &result,
+               bool suppress);
+
+/**
+ * Instance masks of results.detections,the detections kept by nms. The
+ * coefficient x prototype product is only evaluated on the prototype cells
+ * under each box,then upsampled bilinearly to the box in display
+ * coordinates and thresholded at 0.5. The detections are already on the
+ * display,mapping takes them back to the prototype cells.
+ * @param[in] proto: prototype masks,NHWC or NCHW,float or SCALE quantized
+ * @return 0 if success
+ */
+extern int yolov5_seg_BuildMasks(const hbDNNTensor *proto,
+                 const bpu_image_info_t &image_info,
+                 const CoordMapping &mapping,
+                 InstanceSegmentation &results);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef yolov8_post
+#define yolov8_post
+
+#include <vector>
+#include "sp_bpu.h"
+#include "yolo_dfl_decoder.hpp"
+#include "yolov5_post_process.hpp"
+
+typedef YoloDflConfig PTQYolo8Config;
+
+const float yolov8_score_threshold_ = 0.25;
+const float yolov8_nms_threshold_ = 0.45;
+const int yolov8_nms_top_k_ = 300;
+const int yolov8_head_nums_ = 3;
+// class and box output of every head
+const int yolov8_output_nums_ = 2 * yolov8_head_nums_;
+
+
+/**
+ * Decode output head layer (tensors[2 * layer] classes,tensors[2 * layer + 1]
+ * box bins) with DflYoloDecoder,boxes come out in model input pixels
+ * through plan.
+ */
+extern void yolov8_ParseTensor(const hbDNNTensor *tensors,
+                 const YoloDecodePlan &plan,
+                 int layer,
+                 DetectionBatch &results);
+
+/**
+ * Build the decode plan of the yolov8 heads in tensors for image_info.
+ * @return 0 if success
+ */
+extern int yolov8_BuildDecodePlan(const hbDNNTensor *tensors,
+                 const bpu_image_info_t &image_info,
+                 YoloDecodePlan &plan);
+
+#endif
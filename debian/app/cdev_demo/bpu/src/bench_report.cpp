@@ -0,0 +1,135 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: headless benchmark bookkeeping and json report
+ ***************************************************************************/
+#include <stdio.h>
+#include <pthread.h>
+#include "bench_report.hpp"
+#include "stage_latency.hpp"
+
+static int64_t ReadClockNs(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts))
+        return 0; //thread already exited
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+ThreadCpuTimes &ThreadCpuTimes::Get()
+{
+    static ThreadCpuTimes instance;
+    return instance;
+}
+
+ThreadCpuTimes::Registration::~Registration()
+{
+    if (index_ >= 0)
+        ThreadCpuTimes::Get().Exit(index_);
+}
+
+ThreadCpuTimes::Registration ThreadCpuTimes::Register(const char *name)
+{
+    Entry entry;
+    entry.name = name;
+    if (pthread_getcpuclockid(pthread_self(), &entry.clock))
+        return Registration(-1);
+    entry.start_ns = 0;
+    entry.end_ns = 0;
+    std::lock_guard<std::mutex> lock(mtx_);
+    entries_.push_back(entry);
+    return Registration(entries_.size() - 1);
+}
+
+void ThreadCpuTimes::Exit(int index)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (measuring_)
+        entries_[index].end_ns = ReadClockNs(entries_[index].clock); //still our own clock here
+}
+
+void ThreadCpuTimes::MarkStart()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (size_t i = 0; i < entries_.size(); i++)
+    {
+        entries_[i].start_ns = ReadClockNs(entries_[i].clock);
+        entries_[i].end_ns = 0;
+    }
+    measuring_ = true;
+}
+
+void ThreadCpuTimes::MarkEnd()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (size_t i = 0; i < entries_.size(); i++)
+    {
+        if (!entries_[i].end_ns)
+            entries_[i].end_ns = ReadClockNs(entries_[i].clock); //exited threads sampled themselves
+    }
+    measuring_ = false;
+}
+
+std::vector<ThreadCpuTimes::Entry> ThreadCpuTimes::entries()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return entries_;
+}
+
+int WriteBenchReport(const std::string &path, const BenchStats &stats)
+{
+    FILE *fp = path.empty() ? stdout : fopen(path.c_str(), "w");
+    if (!fp)
+    {
+        printf("open bench report %s failed\n", path.c_str());
+        return -1;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"model\": \"%s\",\n", stats.model.c_str());
+    fprintf(fp, "  \"mode\": %d,\n", stats.mode);
+    fprintf(fp, "  \"in_flight\": %d,\n", stats.in_flight);
+    fprintf(fp, "  \"post_workers\": %d,\n", stats.post_workers);
+    fprintf(fp, "  \"ring_depth\": %d,\n", stats.ring_depth);
+    fprintf(fp, "  \"warmup_frames\": %d,\n", stats.warmup_frames);
+    fprintf(fp, "  \"completed\": %s,\n", stats.completed ? "true" : "false");
+    fprintf(fp, "  \"frames\": %llu,\n", (unsigned long long)stats.frames);
+    fprintf(fp, "  \"seconds\": %.3f,\n", stats.seconds);
+    fprintf(fp, "  \"fps\": %.2f,\n", stats.seconds > 0 ? stats.frames / stats.seconds : 0.0);
+    fprintf(fp, "  \"dropped\": {\"ring\": %llu, \"pool_exhausted\": %llu, \"capture_failures\": %llu},\n",
+            (unsigned long long)stats.ring_dropped, (unsigned long long)stats.pool_exhausted,
+            (unsigned long long)stats.capture_failures);
+
+    fprintf(fp, "  \"latency_us\": {");
+    const char *sep = "\n";
+    for (int i = 0; i < kStageCount; i++)
+    {
+        const LatencyHistogram &histogram = StageLatency::Get().histogram((LatencyStage)i);
+        uint64_t count = histogram.count();
+        if (!count)
+            continue;
+        fprintf(fp, "%s    \"%s\": {\"count\": %llu, \"mean\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu}",
+                sep, StageLatency::StageName((LatencyStage)i), (unsigned long long)count, (unsigned long long)(histogram.sum() / count),
+                (unsigned long long)histogram.Percentile(0.5), (unsigned long long)histogram.Percentile(0.9),
+                (unsigned long long)histogram.Percentile(0.99), (unsigned long long)histogram.max());
+        sep = ",\n";
+    }
+    fprintf(fp, "\n  },\n");
+
+    fprintf(fp, "  \"thread_cpu\": [");
+    std::vector<ThreadCpuTimes::Entry> threads = ThreadCpuTimes::Get().entries();
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        //a thread that never got an end sample reports nothing rather than a negative time
+        double cpu_seconds = threads[i].end_ns > threads[i].start_ns ? (threads[i].end_ns - threads[i].start_ns) / 1e9 : 0.0;
+        fprintf(fp, "%s\n    {\"thread\": \"%s\", \"cpu_seconds\": %.3f, \"cpu_usage\": %.3f}", i ? "," : "",
+                threads[i].name.c_str(), cpu_seconds, stats.seconds > 0 ? cpu_seconds / stats.seconds : 0.0);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    if (fp != stdout)
+    {
+        fclose(fp);
+        printf("bench report written to %s\n", path.c_str());
+    }
+    return 0;
+}
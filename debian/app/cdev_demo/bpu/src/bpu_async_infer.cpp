@@ -0,0 +1,143 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: keeps several bpu inferences in flight with hbDNNInfer task
+ *               handles and hands them to post processing in frame order
+ ***************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "bpu_async_infer.hpp"
+#include "bench_report.hpp"
+
+BpuAsyncInfer::BpuAsyncInfer(SpscRing<bpu_work> &done_ring, BpuTensorPool &pool)
+    : done_ring_(done_ring), pool_(pool), inflight_ring_(BPU_MAX_IN_FLIGHT), free_slots_(BPU_MAX_IN_FLIGHT)
+{
+}
+
+BpuAsyncInfer::~BpuAsyncInfer()
+{
+    Stop();
+}
+
+int BpuAsyncInfer::Start(bpu_module *bpu, int in_flight, int frame_size)
+{
+    if (in_flight < 1 || in_flight > BPU_MAX_IN_FLIGHT)
+    {
+        printf("in flight must be 1~%d\n", BPU_MAX_IN_FLIGHT);
+        return -1;
+    }
+    bpu_ = bpu;
+    hbDNNTensorProperties properties;
+    int ret = hbDNNGetInputTensorProperties(&properties, bpu_->m_dnn_handle, 0);
+    if (ret)
+    {
+        printf("get input tensor properties failed,ret = %d\n", ret);
+        return ret;
+    }
+    //the vio writes packed nv12,tell the bpu there is no row padding
+    properties.alignedShape = properties.validShape;
+    int mem_size = properties.alignedByteSize > frame_size ? properties.alignedByteSize : frame_size;
+    input_tensors_.resize(in_flight);
+    for (int i = 0; i < in_flight; i++)
+    {
+        hbDNNTensor &input = input_tensors_[i];
+        memset(&input, 0, sizeof(input));
+        input.properties = properties;
+        ret = hbSysAllocCachedMem(&input.sysMem[0], mem_size);
+        if (ret)
+        {
+            printf("alloc input tensor %d failed,ret = %d\n", i, ret);
+            input_tensors_.resize(i);
+            return ret;
+        }
+        free_slots_.push(i);
+    }
+    completion_thread_ = std::thread(&BpuAsyncInfer::CompletionLoop, this);
+    started_ = true;
+    return 0;
+}
+
+hbDNNTensor *BpuAsyncInfer::AcquireInput()
+{
+    if (spare_input_)
+    {
+        hbDNNTensor *input = spare_input_;
+        spare_input_ = nullptr;
+        return input;
+    }
+    int slot;
+    if (!free_slots_.pop(slot)) //blocks while every input tensor is in flight
+        return nullptr;
+    return &input_tensors_[slot];
+}
+
+void BpuAsyncInfer::ReturnInput(hbDNNTensor *input)
+{
+    spare_input_ = input; //free_slots_ has a single producer,the completion thread
+}
+
+int BpuAsyncInfer::Submit(hbDNNTensor *input, const bpu_work &work)
+{
+    LatencyClock::time_point start = LatencyClock::now();
+    int slot = input - input_tensors_.data();
+    hbSysFlushMem(&input->sysMem[0], HB_SYS_MEM_CACHE_CLEAN); //sp_vio_get_frame and the pre processors write through the cpu cache
+
+    InflightTask inflight;
+    inflight.task = nullptr;
+    inflight.input_slot = slot;
+    inflight.work = work;
+    hbDNNTensor *output = work.lease->tensors;
+    hbDNNInferCtrlParam infer_ctrl_param;
+    HB_DNN_INITIALIZE_INFER_CTRL_PARAM(&infer_ctrl_param);
+    int ret = hbDNNInfer(&inflight.task, &output, input, bpu_->m_dnn_handle, &infer_ctrl_param);
+    if (ret)
+    {
+        printf("hbDNNInfer failed,ret = %d\n", ret);
+        ReturnInput(input);
+        pool_.Release(work.lease);
+        return ret;
+    }
+    inflight.work.submit_time = RecordStage(kStageBpuSubmit, start);
+    inflight_ring_.push(inflight); //never blocks,there are at most as many tasks as input tensors
+    return 0;
+}
+
+void BpuAsyncInfer::CompletionLoop()
+{
+    ThreadCpuTimes::Registration cpu_time = ThreadCpuTimes::Get().Register("bpu_completion");
+    InflightTask inflight;
+    while (inflight_ring_.pop(inflight)) //tasks complete in the order they were submitted
+    {
+        int ret = hbDNNWaitTaskDone(inflight.task, 0);
+        if (ret)
+        {
+            printf("hbDNNWaitTaskDone failed,ret = %d\n", ret);
+        }
+        RecordStage(kStageBpuDone, inflight.work.submit_time);
+        hbDNNReleaseTask(inflight.task);
+        free_slots_.push(inflight.input_slot);
+        if (ret)
+            pool_.Release(inflight.work.lease);
+        else
+            PushWork(done_ring_, pool_, inflight.work); //blocks or drops according to the overflow policy
+    }
+    done_ring_.close(); //wake up post processing thread
+}
+
+void BpuAsyncInfer::Stop()
+{
+    if (started_)
+    {
+        inflight_ring_.close(); //the completion thread drains the remaining tasks and exits
+        completion_thread_.join();
+        free_slots_.close();
+        started_ = false;
+    }
+    for (size_t i = 0; i < input_tensors_.size(); i++)
+    {
+        hbSysFreeMem(&input_tensors_[i].sysMem[0]);
+    }
+    input_tensors_.clear();
+    spare_input_ = nullptr;
+}
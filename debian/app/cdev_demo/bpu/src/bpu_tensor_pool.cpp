@@ -0,0 +1,103 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: pool of bpu output tensor groups handed out as ref counted
+ *               leases,sized from the model output count
+ ***************************************************************************/
+#include <stdio.h>
+#include "bpu_tensor_pool.hpp"
+
+BpuTensorPool::~BpuTensorPool()
+{
+    Deinit();
+}
+
+int BpuTensorPool::Init(bpu_module *bpu, int groups, PoolExhaustPolicy policy)
+{
+    int ret = hbDNNGetOutputCount(&output_count_, bpu->m_dnn_handle);
+    if (ret || output_count_ <= 0)
+    {
+        printf("get model output count failed,ret = %d\n", ret);
+        return -1;
+    }
+    policy_ = policy;
+    tensors_.resize(groups * output_count_);
+    groups_.reset(new BpuTensorGroup[groups]);
+    for (int i = 0; i < groups; i++)
+    {
+        BpuTensorGroup &group = groups_[i];
+        group.tensors = &tensors_[i * output_count_];
+        group.index = i;
+        group.refs.store(0, std::memory_order_relaxed);
+        ret = sp_init_bpu_tensors(bpu, group.tensors);
+        if (ret)
+        {
+            printf("prepare model output tensor failed\n");
+            Deinit();
+            return ret;
+        }
+        group_count_++;
+        free_.push_back(&group);
+    }
+    closed_ = false;
+    return 0;
+}
+
+void BpuTensorPool::Deinit()
+{
+    for (int i = 0; i < group_count_; i++)
+    {
+        sp_deinit_bpu_tensor(groups_[i].tensors, output_count_); //release tensor
+    }
+    group_count_ = 0;
+    groups_.reset();
+    tensors_.clear();
+    free_.clear();
+}
+
+BpuTensorGroup *BpuTensorPool::Acquire()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (free_.empty())
+    {
+        exhausted_.fetch_add(1, std::memory_order_relaxed);
+        if (policy_ == PoolExhaustPolicy::kDrop)
+            return nullptr;
+        while (free_.empty() && !closed_)
+        {
+            free_cv_.wait(lock);
+        }
+    }
+    if (closed_)
+        return nullptr;
+    BpuTensorGroup *group = free_.back();
+    free_.pop_back();
+    group->refs.store(1, std::memory_order_relaxed);
+    int in_use = in_use_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (in_use > high_water_.load(std::memory_order_relaxed))
+        high_water_.store(in_use, std::memory_order_relaxed);
+    return group;
+}
+
+void BpuTensorPool::AddRef(BpuTensorGroup *group)
+{
+    group->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BpuTensorPool::Release(BpuTensorGroup *group)
+{
+    if (group->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    free_.push_back(group);
+    in_use_.fetch_sub(1, std::memory_order_relaxed);
+    free_cv_.notify_one();
+}
+
+void BpuTensorPool::Close()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    closed_ = true;
+    free_cv_.notify_all();
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: model input -> display coordinates,built once per pipeline
+ *               from the geometry the pre processing used
+ ***************************************************************************/
+#include <algorithm>
+#include "coord_mapping.hpp"
+
+InputGeometry InputGeometry::Stretch(const bpu_image_info_t &image_info)
+{
+    InputGeometry geometry;
+    geometry.crop_x = 0;
+    geometry.crop_y = 0;
+    geometry.crop_width = image_info.m_ori_width;
+    geometry.crop_height = image_info.m_ori_height;
+    geometry.resize_width = image_info.m_model_w;
+    geometry.resize_height = image_info.m_model_h;
+    geometry.pad_x = 0;
+    geometry.pad_y = 0;
+    return geometry;
+}
+
+InputGeometry InputGeometry::Letterbox(const bpu_image_info_t &image_info, int source_width, int source_height)
+{
+    if (source_width <= 0 || source_height <= 0)
+    {
+        source_width = image_info.m_ori_width;
+        source_height = image_info.m_ori_height;
+    }
+    InputGeometry geometry;
+    geometry.crop_x = 0;
+    geometry.crop_y = 0;
+    geometry.crop_width = image_info.m_ori_width;
+    geometry.crop_height = image_info.m_ori_height;
+    //the side that fits exactly keeps the model size,the other one is rounded
+    if ((long long)image_info.m_model_w * source_height <= (long long)image_info.m_model_h * source_width)
+    {
+        geometry.resize_width = image_info.m_model_w;
+        geometry.resize_height = (int)((long long)source_height * image_info.m_model_w / source_width);
+    }
+    else
+    {
+        geometry.resize_width = (int)((long long)source_width * image_info.m_model_h / source_height);
+        geometry.resize_height = image_info.m_model_h;
+    }
+    //nv12 takes even sizes and offsets,the uv plane is subsampled by 2
+    geometry.resize_width = std::max(geometry.resize_width & ~1, 2);
+    geometry.resize_height = std::max(geometry.resize_height & ~1, 2);
+    geometry.pad_x = ((image_info.m_model_w - geometry.resize_width) / 2) & ~1;
+    geometry.pad_y = ((image_info.m_model_h - geometry.resize_height) / 2) & ~1;
+    return geometry;
+}
+
+CoordMapping CoordMapping::Build(const InputGeometry &geometry)
+{
+    //done once in double,Apply() is multiply-adds only
+    double scale_x = geometry.crop_width * 1.0 / geometry.resize_width;
+    double scale_y = geometry.crop_height * 1.0 / geometry.resize_height;
+    CoordMapping mapping;
+    mapping.scale_x = scale_x;
+    mapping.scale_y = scale_y;
+    mapping.offset_x = geometry.crop_x - geometry.pad_x * scale_x;
+    mapping.offset_y = geometry.crop_y - geometry.pad_y * scale_y;
+    mapping.min_x = geometry.crop_x;
+    mapping.min_y = geometry.crop_y;
+    mapping.max_x = geometry.crop_x + geometry.crop_width - 1.0f;
+    mapping.max_y = geometry.crop_y + geometry.crop_height - 1.0f;
+    return mapping;
+}
+
+void CoordMapping::Apply(DetectionBatch &batch) const
+{
+    batch.Map(scale_x, scale_y, offset_x, offset_y);
+    batch.Clip(min_x, min_y, max_x, max_y);
+}
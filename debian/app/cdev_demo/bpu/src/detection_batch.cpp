@@ -0,0 +1,123 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: detections of one frame as structure of arrays,written by
+ *               every detector and read by nms and drawing as they are
+ ***************************************************************************/
+#include <algorithm>
+#include "detection_batch.hpp"
+
+void DetectionBatch::Reserve(int capacity, int extra_dim)
+{
+    if (capacity > capacity_)
+    {
+        //at least doubled,so batches filled by Append() settle quickly
+        capacity_ = std::max(capacity, 2 * capacity_);
+        id_.resize(capacity_);
+        xmin_.resize(capacity_);
+        ymin_.resize(capacity_);
+        xmax_.resize(capacity_);
+        ymax_.resize(capacity_);
+        score_.resize(capacity_);
+    }
+    extra_dim_ = extra_dim;
+    if (extra_.size() < (size_t)capacity_ * extra_dim_)
+        extra_.resize((size_t)capacity_ * extra_dim_);
+}
+
+void DetectionBatch::Append(const DetectionBatch &other)
+{
+    int n = other.size_;
+    if (n == 0)
+        return;
+    Reserve(size_ + n, other.extra_dim_);
+    std::copy(other.id_.begin(), other.id_.begin() + n, id_.begin() + size_);
+    std::copy(other.xmin_.begin(), other.xmin_.begin() + n, xmin_.begin() + size_);
+    std::copy(other.ymin_.begin(), other.ymin_.begin() + n, ymin_.begin() + size_);
+    std::copy(other.xmax_.begin(), other.xmax_.begin() + n, xmax_.begin() + size_);
+    std::copy(other.ymax_.begin(), other.ymax_.begin() + n, ymax_.begin() + size_);
+    std::copy(other.score_.begin(), other.score_.begin() + n, score_.begin() + size_);
+    std::copy(other.extra_.begin(), other.extra_.begin() + (size_t)n * extra_dim_, extra_.begin() + (size_t)size_ * extra_dim_);
+    size_ += n;
+    class_names_ = other.class_names_;
+}
+
+void DetectionBatch::Gather(const DetectionBatch &from, const int *index, int count)
+{
+    size_ = 0;
+    Reserve(count, from.extra_dim_);
+    for (int i = 0; i < count; i++)
+    {
+        int k = index[i];
+        id_[i] = from.id_[k];
+        xmin_[i] = from.xmin_[k];
+        ymin_[i] = from.ymin_[k];
+        xmax_[i] = from.xmax_[k];
+        ymax_[i] = from.ymax_[k];
+        score_[i] = from.score_[k];
+        std::copy(from.Extra(k), from.Extra(k) + extra_dim_, Extra(i));
+    }
+    size_ = count;
+    class_names_ = from.class_names_;
+}
+
+void DetectionBatch::Map(float scale_x, float scale_y, float offset_x, float offset_y)
+{
+    //branch free loops over contiguous floats,the compiler vectorizes them
+    for (int i = 0; i < size_; i++)
+    {
+        xmin_[i] = xmin_[i] * scale_x + offset_x;
+    }
+    for (int i = 0; i < size_; i++)
+    {
+        xmax_[i] = xmax_[i] * scale_x + offset_x;
+    }
+    for (int i = 0; i < size_; i++)
+    {
+        ymin_[i] = ymin_[i] * scale_y + offset_y;
+    }
+    for (int i = 0; i < size_; i++)
+    {
+        ymax_[i] = ymax_[i] * scale_y + offset_y;
+    }
+}
+
+void DetectionBatch::Clip(float min_x, float min_y, float max_x, float max_y)
+{
+    for (int i = 0; i < size_; i++)
+    {
+        xmin_[i] = std::max(xmin_[i], min_x);
+    }
+    for (int i = 0; i < size_; i++)
+    {
+        ymin_[i] = std::max(ymin_[i], min_y);
+    }
+    for (int i = 0; i < size_; i++)
+    {
+        xmax_[i] = std::min(xmax_[i], max_x);
+    }
+    for (int i = 0; i < size_; i++)
+    {
+        ymax_[i] = std::min(ymax_[i], max_y);
+    }
+    //compact in place,nothing moves until the first dropped box
+    int kept = 0;
+    for (int i = 0; i < size_; i++)
+    {
+        if (xmin_[i] > xmax_[i] || ymin_[i] > ymax_[i])
+            continue;
+        if (kept != i)
+        {
+            id_[kept] = id_[i];
+            xmin_[kept] = xmin_[i];
+            ymin_[kept] = ymin_[i];
+            xmax_[kept] = xmax_[i];
+            ymax_[kept] = ymax_[i];
+            score_[kept] = score_[i];
+            std::copy(Extra(i), Extra(i) + extra_dim_, Extra(kept));
+        }
+        kept++;
+    }
+    size_ = kept;
+}
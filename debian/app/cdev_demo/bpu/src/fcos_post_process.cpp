@@ -17,9 +17,16 @@
 #include <algorithm>
 
 #include "fcos_post_process.hpp"
+#include "bpu_kernels.hpp"
+#include "frame_arena.hpp"
+#include "nms_engine.hpp"
+#include "stage_latency.hpp"
 float score_hold = 0.45;
 float iou_threshold = 0.6;
 int top_k = 500;
+// from this many candidates on nms buckets them in a spatial grid,keeps its
+// cost near linear in crowded frames without dropping candidates
+static const int nms_grid_candidates = 512;
 /**
  * Config definition for Fcos
  */
@@ -80,87 +87,22 @@ static int get_tensor_hwc_index(hbDNNTensor *tensor,
   return 0;
 }
 
-static void fcos_nms(std::vector<Detection> &input,
+static void fcos_nms(const DetectionBatch &input,
                      float iou_threshold,
                      int top_k,
-                     std::vector<Detection> &result,
+                     DetectionBatch &result,
                      bool suppress)
 {
-  // sort order by score desc
-  std::stable_sort(input.begin(), input.end(), std::greater<Detection>());
-
-  std::vector<bool> skip(input.size(), false);
-
-  // pre-calculate boxes area
-  std::vector<float> areas;
-  areas.reserve(input.size());
-  for (size_t i = 0; i < input.size(); i++)
-  {
-    float width = input[i].bbox.xmax - input[i].bbox.xmin;
-    float height = input[i].bbox.ymax - input[i].bbox.ymin;
-    areas.push_back(width * height);
-  }
-
-  int count = 0;
-  for (size_t i = 0; count < top_k && i < skip.size(); i++)
-  {
-    if (skip[i])
-    {
-      continue;
-    }
-    skip[i] = true;
-    ++count;
-
-    for (size_t j = i + 1; j < skip.size(); ++j)
-    {
-      if (skip[j])
-      {
-        continue;
-      }
-      if (suppress == false)
-      {
-        if (input[i].id != input[j].id)
-        {
-          continue;
-        }
-      }
-
-      // intersection area
-      float xx1 = std::max(input[i].bbox.xmin, input[j].bbox.xmin);
-      float yy1 = std::max(input[i].bbox.ymin, input[j].bbox.ymin);
-      float xx2 = std::min(input[i].bbox.xmax, input[j].bbox.xmax);
-      float yy2 = std::min(input[i].bbox.ymax, input[j].bbox.ymax);
-
-      if (xx2 > xx1 && yy2 > yy1)
-      {
-        float area_intersection = (xx2 - xx1) * (yy2 - yy1);
-        float iou_ratio =
-            area_intersection / (areas[j] + areas[i] - area_intersection);
-        if (iou_ratio > iou_threshold)
-        {
-          skip[j] = true;
-        }
-      }
-    }
-    result.push_back(input[i]);
-  }
+  NmsParams params = {iou_threshold, top_k, suppress,
+                      nms_grid_candidates};
+  NmsBatch(input, params, result);
 }
 
 static void GetBboxAndScoresNHWC(
     hbDNNTensor *tensors,
-    bpu_image_info_t *post_info,
-    std::vector<Detection> &dets)
+    DetectionBatch &dets)
 {
-  int ori_h = post_info->m_ori_height;
-  int ori_w = post_info->m_ori_width;
-  int input_h = post_info->m_model_h;
-  int input_w = post_info->m_model_w;
-  float w_scale;
-  float h_scale;
-  // preprocess action is pad and resize
-  w_scale = static_cast<float>(ori_w) / input_w;
-  h_scale = static_cast<float>(ori_h) / input_h;
-
+  // boxes stay in model input pixels,the pipeline maps them to the display
   // fcos stride is {8, 16, 32, 64, 128}
   for (int i = 0; i < 5; i++)
   {
@@ -175,6 +117,7 @@ static void GetBboxAndScoresNHWC(
     int tensor_h = shape[1];
     int tensor_w = shape[2];
     int tensor_c = shape[3];
+    dets.Reserve(dets.Size() + tensor_h * tensor_w);
 
     for (int h = 0; h < tensor_h; h++)
     {
@@ -183,42 +126,25 @@ static void GetBboxAndScoresNHWC(
       {
         // get score
         int ce_offset = offset + w;
-        ce_data[ce_offset] = 1.0 / (1.0 + exp(-ce_data[ce_offset]));
+        ce_data[ce_offset] = Sigmoid<KernelAccuracy::kExact>(ce_data[ce_offset]);
 
         int cls_offset = ce_offset * tensor_c;
-        ScoreId tmp_score = {cls_data[cls_offset], 0};
-        for (int cls_c = 1; cls_c < tensor_c; cls_c++)
-        {
-          int cls_index = cls_offset + cls_c;
-          if (cls_data[cls_index] > tmp_score.score)
-          {
-            tmp_score.id = cls_c;
-            tmp_score.score = cls_data[cls_index];
-          }
-        }
-        tmp_score.score = 1.0 / (1.0 + exp(-tmp_score.score));
+        int cls_id = Argmax(cls_data + cls_offset, tensor_c);
+        ScoreId tmp_score = {cls_data[cls_offset + cls_id], cls_id};
+        tmp_score.score = Sigmoid<KernelAccuracy::kExact>(tmp_score.score);
         tmp_score.score = std::sqrt(tmp_score.score * ce_data[ce_offset]);
         if (tmp_score.score <= score_hold)
           continue;
 
         // get detection box
-        Detection detection;
         int index = 4 * (h * tensor_w + w);
         auto &strides = fcos_config_.strides;
-
-        detection.bbox.xmin =
-            ((w + 0.5) * strides[i] - bbox_data[index]) * w_scale;
-        detection.bbox.ymin =
-            ((h + 0.5) * strides[i] - bbox_data[index + 1]) * h_scale;
-        detection.bbox.xmax =
-            ((w + 0.5) * strides[i] + bbox_data[index + 2]) * w_scale;
-        detection.bbox.ymax =
-            ((h + 0.5) * strides[i] + bbox_data[index + 3]) * h_scale;
-
-        detection.score = tmp_score.score;
-        detection.id = tmp_score.id;
-        detection.class_name = fcos_config_.class_names[detection.id].c_str();
-        dets.push_back(detection);
+        dets.Push(tmp_score.id,
+                  (w + 0.5) * strides[i] - bbox_data[index],
+                  (h + 0.5) * strides[i] - bbox_data[index + 1],
+                  (w + 0.5) * strides[i] + bbox_data[index + 2],
+                  (h + 0.5) * strides[i] + bbox_data[index + 3],
+                  tmp_score.score);
       }
     }
   }
@@ -226,18 +152,9 @@ static void GetBboxAndScoresNHWC(
 
 static void GetBboxAndScoresNCHW(
     hbDNNTensor *tensors,
-    bpu_image_info_t *post_info,
-    std::vector<Detection> &dets)
+    DetectionBatch &dets)
 {
-  int ori_h = post_info->m_ori_height;
-  int ori_w = post_info->m_ori_width;
-  int input_h = post_info->m_model_h;
-  int input_w = post_info->m_model_w;
-  float w_scale;
-  float h_scale;
-  // preprocess action is pad and resize
-  w_scale = static_cast<float>(ori_w) / input_w;
-  h_scale = static_cast<float>(ori_h) / input_h;
+  // boxes stay in model input pixels,the pipeline maps them to the display
 
   for (int i = 0; i < 5; i++)
   {
@@ -253,6 +170,7 @@ static void GetBboxAndScoresNCHW(
     int tensor_h = shape[2];
     int tensor_w = shape[3];
     int aligned_hw = tensor_h * tensor_w;
+    dets.Reserve(dets.Size() + tensor_h * tensor_w);
 
     for (int h = 0; h < tensor_h; h++)
     {
@@ -261,8 +179,9 @@ static void GetBboxAndScoresNCHW(
       {
         // get score
         int ce_offset = offset + w;
-        ce_data[ce_offset] = 1.0 / (1.0 + exp(-ce_data[ce_offset]));
+        ce_data[ce_offset] = Sigmoid<KernelAccuracy::kExact>(ce_data[ce_offset]);
 
+        // channels are aligned_hw apart,too far for a vector argmax
         ScoreId tmp_score = {cls_data[offset + w], 0};
         for (int cls_c = 1; cls_c < tensor_c; cls_c++)
         {
@@ -273,39 +192,34 @@ static void GetBboxAndScoresNCHW(
             tmp_score.score = cls_data[cls_index];
           }
         }
-        tmp_score.score = 1.0 / (1.0 + exp(-tmp_score.score));
+        tmp_score.score = Sigmoid<KernelAccuracy::kExact>(tmp_score.score);
         tmp_score.score = std::sqrt(tmp_score.score * ce_data[ce_offset]);
         if (tmp_score.score <= score_hold)
           continue;
 
         // get detection box
         auto &strides = fcos_config_.strides;
-        Detection detection;
-        detection.bbox.xmin =
-            ((w + 0.5) * strides[i] - bbox_data[offset + w]) * w_scale;
-        detection.bbox.ymin =
-            ((h + 0.5) * strides[i] - bbox_data[1 * aligned_hw + offset + w]) *
-            h_scale;
-        detection.bbox.xmax =
-            ((w + 0.5) * strides[i] + bbox_data[2 * aligned_hw + offset + w]) *
-            w_scale;
-        detection.bbox.ymax =
-            ((h + 0.5) * strides[i] + bbox_data[3 * aligned_hw + offset + w]) *
-            h_scale;
-
-        detection.score = tmp_score.score;
-        detection.id = tmp_score.id;
-        detection.class_name = fcos_config_.class_names[detection.id].c_str();
-        dets.push_back(detection);
+        dets.Push(tmp_score.id,
+                  (w + 0.5) * strides[i] - bbox_data[offset + w],
+                  (h + 0.5) * strides[i] -
+                  bbox_data[1 * aligned_hw + offset + w],
+                  (w + 0.5) * strides[i] +
+                  bbox_data[2 * aligned_hw + offset + w],
+                  (h + 0.5) * strides[i] +
+                  bbox_data[3 * aligned_hw + offset + w],
+                  tmp_score.score);
       }
     }
   }
 }
 
-void fcos_post_process(hbDNNTensor* tensors, bpu_image_info_t *post_info, std::vector<Detection> &det_restuls)
+void fcos_post_process(hbDNNTensor* tensors, DetectionBatch &det_restuls)
 {
-
-  std::vector<Detection> dets;
+  LatencyClock::time_point start = LatencyClock::now();
+  // kept per post thread,Clear() keeps the capacity of earlier frames
+  static thread_local DetectionBatch dets;
+  dets.Clear();
+  dets.SetClassNames(&fcos_config_.class_names);
 
   int h_index, w_index, c_index;
   int ret = get_tensor_hwc_index(&tensors[0], &h_index, &w_index, &c_index);
@@ -316,17 +230,19 @@ void fcos_post_process(hbDNNTensor* tensors, bpu_image_info_t *post_info, std::v
   }
   if (tensors[0].properties.tensorLayout == HB_DNN_LAYOUT_NHWC)
   {
-    GetBboxAndScoresNHWC(tensors, post_info, dets);
+    GetBboxAndScoresNHWC(tensors, dets);
   }
   else if (tensors[0].properties.tensorLayout == HB_DNN_LAYOUT_NCHW)
   {
-    GetBboxAndScoresNCHW(tensors, post_info, dets);
+    GetBboxAndScoresNCHW(tensors, dets);
   }
   else
   {
     printf("tensor layout error.\n");
     return ;
   }
+  start = RecordStage(kStageTensorParse, start);
   // 计算交并比来合并检测框，传入交并比阈值和返回box数量
   fcos_nms(dets, iou_threshold, top_k, det_restuls, false);
+  RecordStage(kStageNms, start);
 }
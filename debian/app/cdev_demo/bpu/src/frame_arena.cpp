@@ -0,0 +1,62 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: per thread bump allocator for post process scratch,rewound
+ *               instead of freed so a steady frame loop does not allocate
+ ***************************************************************************/
+#include <stdlib.h>
+#include <algorithm>
+#include "frame_arena.hpp"
+
+#define FRAME_ARENA_GRANULE (4096)
+
+FrameArena::~FrameArena()
+{
+    Rewind(0);
+    free(block_);
+}
+
+FrameArena &FrameArena::ThisThread()
+{
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+void *FrameArena::Alloc(size_t bytes, size_t align)
+{
+    size_t offset = (used_ + align - 1) & ~(align - 1);
+    //overflow allocations move used_ on as well,so a scope opened after one
+    //has a mark past it and does not free it on exit
+    used_ = offset + bytes;
+    if (used_ <= capacity_)
+        return block_ + offset;
+    //block is full,serve this frame from an overflow block and grow later
+    uint8_t *overflow = static_cast<uint8_t *>(malloc(bytes + align));
+    if (!overflow)
+        return nullptr;
+    overflow_.push_back(overflow);
+    peak_ = std::max(peak_, used_);
+    uintptr_t addr = reinterpret_cast<uintptr_t>(overflow);
+    return reinterpret_cast<void *>((addr + align - 1) & ~(uintptr_t)(align - 1));
+}
+
+void FrameArena::Rewind(size_t mark)
+{
+    used_ = mark;
+    if (mark != 0 || overflow_.empty())
+        return;
+    for (size_t i = 0; i < overflow_.size(); i++)
+    {
+        free(overflow_[i]);
+    }
+    overflow_.clear();
+    size_t capacity = (peak_ + FRAME_ARENA_GRANULE - 1) / FRAME_ARENA_GRANULE * FRAME_ARENA_GRANULE;
+    peak_ = 0;
+    uint8_t *block = static_cast<uint8_t *>(malloc(capacity));
+    if (!block)
+        return;
+    free(block_);
+    block_ = block;
+    capacity_ = capacity;
+}
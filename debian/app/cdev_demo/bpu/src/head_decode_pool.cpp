@@ -0,0 +1,106 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: persistent helper threads decoding the output heads of one
+ *               frame in parallel
+ ***************************************************************************/
+#include <stdio.h>
+#include <algorithm>
+#include "head_decode_pool.hpp"
+#include "bench_report.hpp"
+
+std::atomic<int> HeadDecodePool::post_workers_{1};
+
+HeadDecodePool::HeadDecodePool(int helpers) : helpers_(helpers > 0 ? helpers : 0)
+{
+}
+
+void HeadDecodePool::SetPostWorkers(int workers)
+{
+    post_workers_.store(std::max(workers, 1), std::memory_order_relaxed);
+}
+
+HeadDecodePool::~HeadDecodePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        threads_[i].join();
+    }
+}
+
+void HeadDecodePool::Start()
+{
+    started_ = true;
+    //more threads than cores only adds wake ups,every post worker has a pool
+    //of its own and keeps a core for itself
+    int cores = std::thread::hardware_concurrency();
+    if (cores > 0)
+        helpers_ = std::min(helpers_, std::max(cores / post_workers_.load(std::memory_order_relaxed) - 1, 0));
+    for (int i = 0; i < helpers_; i++)
+    {
+        threads_.emplace_back(&HeadDecodePool::HelperLoop, this, i);
+    }
+}
+
+void HeadDecodePool::Run(int count, void (*call)(void *, int), void *arg)
+{
+    if (!started_)
+        Start();
+    if (count <= 1 || helpers_ == 0)
+    {
+        for (int head = 0; head < count; head++)
+        {
+            call(arg, head);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        call_ = call;
+        arg_ = arg;
+        count_ = count;
+        next_head_.store(0, std::memory_order_relaxed);
+        busy_ = helpers_;
+        generation_++;
+    }
+    start_cv_.notify_all();
+    TakeHeads();
+    std::unique_lock<std::mutex> lock(mtx_);
+    done_cv_.wait(lock, [this] { return busy_ == 0; });
+}
+
+void HeadDecodePool::TakeHeads()
+{
+    int head;
+    while ((head = next_head_.fetch_add(1, std::memory_order_relaxed)) < count_)
+    {
+        call_(arg_, head);
+    }
+}
+
+void HeadDecodePool::HelperLoop(int id)
+{
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "head_decode_%d", id);
+    ThreadCpuTimes::Registration cpu_time = ThreadCpuTimes::Get().Register(thread_name);
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true)
+    {
+        start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_)
+            break;
+        seen = generation_;
+        lock.unlock();
+        TakeHeads();
+        lock.lock();
+        if (--busy_ == 0)
+            done_cv_.notify_one();
+    }
+}
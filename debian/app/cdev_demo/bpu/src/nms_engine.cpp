@@ -0,0 +1,306 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: greedy nms shared by every detector,boxes as structure of
+ *               arrays,neon iou and bitmask suppression
+ ***************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include "nms_engine.hpp"
+#include "bpu_kernels.hpp"
+#include "frame_arena.hpp"
+
+#define NMS_LANES (8) //candidates tested against a kept box per step,divides 64
+#define NMS_LANE_MASK ((1ull << NMS_LANES) - 1)
+#define NMS_GRID_MAX_SIDE (64) //cells per grid axis at most
+
+/**
+ * Sorted candidates,padded to a multiple of NMS_LANES with empty boxes of
+ * class -1 that never overlap anything.
+ */
+struct SortedBoxes
+{
+    float *xmin;
+    float *ymin;
+    float *xmax;
+    float *ymax;
+    float *area;
+    int *id;
+};
+
+/**
+ * Whether candidate c is of the class of box i and overlaps it by more than
+ * iou_threshold,the cheap tests first.
+ */
+static inline bool Overlap(const SortedBoxes &boxes, int i, int c, float iou_threshold)
+{
+    if (boxes.id[i] != boxes.id[c])
+        return false;
+    float width = std::min(boxes.xmax[i], boxes.xmax[c]) - std::max(boxes.xmin[i], boxes.xmin[c]);
+    float height = std::min(boxes.ymax[i], boxes.ymax[c]) - std::max(boxes.ymin[i], boxes.ymin[c]);
+    if (width <= 0 || height <= 0)
+        return false;
+    float intersection = width * height;
+    return intersection / (boxes.area[i] + boxes.area[c] - intersection) > iou_threshold;
+}
+
+#ifdef BPU_KERNELS_NEON
+/**
+ * Bit k set if candidate j + k is of the class of box i and overlaps it by
+ * more than iou_threshold,k = 0~3.
+ */
+static inline uint32_t Overlaps4(const SortedBoxes &boxes, int i, int j, float32x4_t iou_threshold)
+{
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    float32x4_t width = vsubq_f32(vminq_f32(vdupq_n_f32(boxes.xmax[i]), vld1q_f32(boxes.xmax + j)),
+                                  vmaxq_f32(vdupq_n_f32(boxes.xmin[i]), vld1q_f32(boxes.xmin + j)));
+    float32x4_t height = vsubq_f32(vminq_f32(vdupq_n_f32(boxes.ymax[i]), vld1q_f32(boxes.ymax + j)),
+                                   vmaxq_f32(vdupq_n_f32(boxes.ymin[i]), vld1q_f32(boxes.ymin + j)));
+    float32x4_t intersection = vmulq_f32(vmaxq_f32(width, vdupq_n_f32(0)), vmaxq_f32(height, vdupq_n_f32(0)));
+    float32x4_t area_union = vsubq_f32(vaddq_f32(vdupq_n_f32(boxes.area[i]), vld1q_f32(boxes.area + j)), intersection);
+    //a true division,so the decisions match the scalar iou bit for bit
+    uint32x4_t hit = vcgtq_f32(vdivq_f32(intersection, area_union), iou_threshold);
+    hit = vandq_u32(hit, vceqq_s32(vdupq_n_s32(boxes.id[i]), vld1q_s32(boxes.id + j)));
+    return vaddvq_u32(vandq_u32(hit, vld1q_u32(lane_bits)));
+}
+#endif
+
+/**
+ * Bit k set if candidate j + k is of the class of box i and overlaps it by
+ * more than iou_threshold,k = 0~NMS_LANES-1. Candidates with their bit set
+ * in suppressed may be skipped.
+ */
+static inline uint64_t Overlaps(const SortedBoxes &boxes, int i, int j, float iou_threshold, uint64_t suppressed)
+{
+#ifdef BPU_KERNELS_NEON
+    float32x4_t threshold = vdupq_n_f32(iou_threshold);
+    return Overlaps4(boxes, i, j, threshold) | (Overlaps4(boxes, i, j + 4, threshold) << 4);
+#else
+    uint64_t hits = 0;
+    for (int k = 0; k < NMS_LANES; k++)
+    {
+        if (!(suppressed >> k & 1))
+            hits |= (uint64_t)Overlap(boxes, i, j + k, iou_threshold) << k;
+    }
+    return hits;
+#endif
+}
+
+static inline bool Suppressed(const uint64_t *suppressed, int k)
+{
+    return suppressed[k >> 6] >> (k & 63) & 1;
+}
+
+/**
+ * Every kept box against every later candidate,NMS_LANES at a time.
+ */
+static int PairwiseSelect(const SortedBoxes &sorted, const int *order, int count, int padded, const NmsParams &params,
+                          uint64_t *suppressed, int *keep)
+{
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (Suppressed(suppressed, i))
+            continue;
+        keep[kept++] = order[i];
+        if (kept == params.top_k)
+            break;
+        //the first step also covers candidates up to i,they are decided
+        //already and their bits are not read again
+        for (int j = (i + 1) & ~(NMS_LANES - 1); j < padded; j += NMS_LANES)
+        {
+            uint64_t &word = suppressed[j >> 6];
+            uint64_t lanes = word >> (j & 63) & NMS_LANE_MASK;
+            if (lanes == NMS_LANE_MASK)
+                continue; //every candidate of the step is suppressed already
+            word |= Overlaps(sorted, i, j, params.iou_threshold, lanes) << (j & 63);
+        }
+    }
+    return kept;
+}
+
+/**
+ * Cell range [first, last] of [low, high] on a grid axis starting at origin.
+ */
+static inline void CellRange(float low, float high, float origin, float inverse_cell, int cells, int *first, int *last)
+{
+    float a = (low - origin) * inverse_cell;
+    float b = (high - origin) * inverse_cell;
+    //also catches nan,which compares false
+    *first = a > 0 ? std::min((int)a, cells - 1) : 0;
+    *last = b > 0 ? std::min((int)b, cells - 1) : 0;
+    *last = std::max(*last, *first);
+}
+
+/**
+ * Every candidate is listed in each grid cell its box touches,a kept box is
+ * only tested against the later candidates listed in its own cells. Two
+ * boxes with a positive intersection share the cell of a point inside it,
+ * so nothing the pairwise loop would suppress is missed. Cells are sized
+ * from the mean box,a box then touches few cells and a cell holds few
+ * boxes,nms stays near linear in the candidate count.
+ */
+static int GridSelect(const SortedBoxes &sorted, const int *order, int count, const NmsParams &params,
+                      uint64_t *suppressed, int *keep)
+{
+    FrameArena &arena = FrameArena::ThisThread();
+    ArenaScope scope(arena);
+    float min_x = sorted.xmin[0], min_y = sorted.ymin[0], max_x = sorted.xmax[0], max_y = sorted.ymax[0];
+    double sum_w = 0, sum_h = 0;
+    for (int k = 0; k < count; k++)
+    {
+        min_x = std::min(min_x, sorted.xmin[k]);
+        min_y = std::min(min_y, sorted.ymin[k]);
+        max_x = std::max(max_x, sorted.xmax[k]);
+        max_y = std::max(max_y, sorted.ymax[k]);
+        sum_w += sorted.xmax[k] - sorted.xmin[k];
+        sum_h += sorted.ymax[k] - sorted.ymin[k];
+    }
+    float cell_w = std::max((float)(sum_w / count), (max_x - min_x) / NMS_GRID_MAX_SIDE);
+    float cell_h = std::max((float)(sum_h / count), (max_y - min_y) / NMS_GRID_MAX_SIDE);
+    //zero sized or non finite boxes have no useful grid
+    if (!(cell_w > 0) || !(cell_h > 0) || !std::isfinite(max_x - min_x + max_y - min_y + cell_w + cell_h))
+        return PairwiseSelect(sorted, order, count, (count + NMS_LANES - 1) / NMS_LANES * NMS_LANES, params, suppressed, keep);
+    float inverse_w = 1.0f / cell_w;
+    float inverse_h = 1.0f / cell_h;
+    int cols = std::min((int)((max_x - min_x) * inverse_w) + 1, NMS_GRID_MAX_SIDE);
+    int rows = std::min((int)((max_y - min_y) * inverse_h) + 1, NMS_GRID_MAX_SIDE);
+
+    //cell lists in one array,candidates in sorted order within a cell
+    int cells = cols * rows;
+    int *start = arena.Alloc<int>(cells + 1);
+    std::fill(start, start + cells + 1, 0);
+    int *range = arena.Alloc<int>(4 * count); //first col,last col,first row,last row
+    for (int k = 0; k < count; k++)
+    {
+        int *r = range + 4 * k;
+        CellRange(sorted.xmin[k], sorted.xmax[k], min_x, inverse_w, cols, &r[0], &r[1]);
+        CellRange(sorted.ymin[k], sorted.ymax[k], min_y, inverse_h, rows, &r[2], &r[3]);
+        for (int y = r[2]; y <= r[3]; y++)
+        {
+            for (int x = r[0]; x <= r[1]; x++)
+            {
+                start[y * cols + x + 1]++;
+            }
+        }
+    }
+    for (int c = 0; c < cells; c++)
+    {
+        start[c + 1] += start[c];
+    }
+    int *members = arena.Alloc<int>(start[cells]);
+    int *cursor = arena.Alloc<int>(cells); //next unread entry of every cell
+    std::copy(start, start + cells, cursor);
+    for (int k = 0; k < count; k++)
+    {
+        const int *r = range + 4 * k;
+        for (int y = r[2]; y <= r[3]; y++)
+        {
+            for (int x = r[0]; x <= r[1]; x++)
+            {
+                members[cursor[y * cols + x]++] = k;
+            }
+        }
+    }
+    std::copy(start, start + cells, cursor);
+
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (Suppressed(suppressed, i))
+            continue;
+        keep[kept++] = order[i];
+        if (kept == params.top_k)
+            break;
+        const int *r = range + 4 * i;
+        for (int y = r[2]; y <= r[3]; y++)
+        {
+            for (int x = r[0]; x <= r[1]; x++)
+            {
+                int cell = y * cols + x;
+                //entries up to i are decided,skip them for good
+                int m = cursor[cell];
+                while (m < start[cell + 1] && members[m] <= i)
+                    m++;
+                cursor[cell] = m;
+                for (; m < start[cell + 1]; m++)
+                {
+                    int j = members[m];
+                    if (!Suppressed(suppressed, j) && Overlap(sorted, i, j, params.iou_threshold))
+                        suppressed[j >> 6] |= 1ull << (j & 63);
+                }
+            }
+        }
+    }
+    return kept;
+}
+
+int NmsSelect(const NmsBoxes &boxes, const NmsParams &params, int *keep)
+{
+    int n = boxes.n;
+    if (n <= 0 || params.top_k <= 0)
+        return 0;
+    FrameArena &arena = FrameArena::ThisThread();
+    ArenaScope scope(arena);
+
+    //descending score,ties by index:a total order,the same as a stable sort
+    int *order = arena.Alloc<int>(n);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    const float *score = boxes.score;
+    auto better = [score](int a, int b) { return score[a] > score[b] || (score[a] == score[b] && a < b); };
+    int count = n;
+    std::sort(order, order + count, better);
+
+    int padded = (count + NMS_LANES - 1) / NMS_LANES * NMS_LANES;
+    SortedBoxes sorted;
+    sorted.xmin = arena.Alloc<float>(padded);
+    sorted.ymin = arena.Alloc<float>(padded);
+    sorted.xmax = arena.Alloc<float>(padded);
+    sorted.ymax = arena.Alloc<float>(padded);
+    sorted.area = arena.Alloc<float>(padded);
+    sorted.id = arena.Alloc<int>(padded);
+    for (int k = 0; k < padded; k++)
+    {
+        if (k < count)
+        {
+            int b = order[k];
+            sorted.xmin[k] = boxes.xmin[b];
+            sorted.ymin[k] = boxes.ymin[b];
+            sorted.xmax[k] = boxes.xmax[b];
+            sorted.ymax[k] = boxes.ymax[b];
+            sorted.id[k] = params.class_agnostic ? 0 : boxes.id[b];
+        }
+        else
+        {
+            sorted.xmin[k] = sorted.ymin[k] = sorted.xmax[k] = sorted.ymax[k] = 0;
+            sorted.id[k] = -1;
+        }
+        sorted.area[k] = (sorted.xmax[k] - sorted.xmin[k]) * (sorted.ymax[k] - sorted.ymin[k]);
+    }
+
+    //one bit per sorted candidate
+    int words = (padded + 63) / 64;
+    uint64_t *suppressed = arena.Alloc<uint64_t>(words);
+    memset(suppressed, 0, words * sizeof(uint64_t));
+
+    if (params.grid_min_candidates > 0 && count >= params.grid_min_candidates)
+        return GridSelect(sorted, order, count, params, suppressed, keep);
+    return PairwiseSelect(sorted, order, count, padded, params, suppressed, keep);
+}
+
+void NmsBatch(const DetectionBatch &input, const NmsParams &params, DetectionBatch &result)
+{
+    FrameArena &arena = FrameArena::ThisThread();
+    ArenaScope scope(arena);
+    int n = input.Size();
+    NmsBoxes boxes = {input.XMin(), input.YMin(), input.XMax(), input.YMax(), input.Score(), input.Id(), n};
+    int *keep = arena.Alloc<int>(std::max(std::min(params.top_k, n), 1));
+    int kept = NmsSelect(boxes, params, keep);
+    result.Gather(input, keep, kept);
+}
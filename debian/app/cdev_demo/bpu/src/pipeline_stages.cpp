@@ -0,0 +1,360 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: sources and sinks for ModelPipeline
+ ***************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include "pipeline_stages.hpp"
+#include "sp_display.h"
+#include "sp_codec.h"
+#include "sp_sys.h"
+
+int CameraSource::Open(const PipelineContext &ctx, int width, int height)
+{
+    int widths[2] = {width, ctx.disp_w}; //create 2 chn,one for bpu input tensors,another for diplay.
+    int heights[2] = {height, ctx.disp_h};
+    int chn_num = ctx.disp_w ? 2 : 1; //headless:bpu chn only
+    camera_ = sp_init_vio_module();
+    int ret = sp_open_camera(camera_, 0, -1, chn_num, &(widths[0]), &(heights[0])); //open camera
+    if (ret)
+    {
+        printf("open camera failed,ret = %d\n", ret);
+        sp_release_vio_module(camera_);
+        camera_ = nullptr;
+        return ret;
+    }
+    sleep(1); //for isp to stabilize
+    return 0;
+}
+
+int CameraSource::GetFrame(char *buffer, int width, int height)
+{
+    return sp_vio_get_frame(camera_, buffer, width, height, 2000) ? 1 : 0;
+}
+
+void CameraSource::Close()
+{
+    if (!camera_)
+        return;
+    sp_vio_close(camera_);
+    sp_release_vio_module(camera_);
+    camera_ = nullptr;
+}
+
+int DecoderSource::Open(const PipelineContext &ctx, int width, int height)
+{
+    stream_file_ = ctx.video_path;
+    video_w_ = ctx.video_w;
+    video_h_ = ctx.video_h;
+    int widths[] = {width, ctx.disp_w}; //open 2 chn,one for bpu tensor input,another for display
+    int heights[] = {height, ctx.disp_h};
+    int chn_num = ctx.disp_w ? 2 : 1; //headless:bpu chn only
+    vps_ = sp_init_vio_module();
+    //NOTE!!!!!!!!!!
+    //IF GET ERROR LIKE BAD ATTR,PLEASE CHECK YOUR INPUT RESOLUTION AND OUTPUT RESOLUTION!!!!!
+    int ret = sp_open_vps(vps_, 0, chn_num, SP_VPS_SCALE, video_w_, video_h_, widths, heights, NULL, NULL, NULL, NULL, NULL);
+    printf("vps open ret = %d\n", ret);
+    if (ret)
+    {
+        sp_release_vio_module(vps_);
+        vps_ = nullptr;
+        return ret;
+    }
+    // decoder -> vps -> display
+    ret = StartDecode();
+    if (ret)
+    {
+        Close();
+    }
+    return ret;
+}
+
+int DecoderSource::StartDecode()
+{
+    decoder_ = sp_init_decoder_module();
+    int ret = sp_start_decode(decoder_, stream_file_.c_str(), 0, SP_ENCODER_H264, video_w_, video_h_);
+    printf("decode start ret = %d\n", ret);
+    if (ret)
+    {
+        printf("[Error] sp_start_decode failed\n");
+        sp_release_decoder_module(decoder_);
+        decoder_ = nullptr;
+        return ret;
+    }
+    ret = sp_module_bind(decoder_, SP_MTYPE_DECODER, vps_, SP_MTYPE_VIO); //bind decode to vps,this binding is for scale
+    printf("module bind decoder & vps ret = %d\n", ret);
+    return 0;
+}
+
+void DecoderSource::StopDecode()
+{
+    if (!decoder_)
+        return;
+    sp_module_unbind(decoder_, SP_MTYPE_DECODER, vps_, SP_MTYPE_VIO);
+    sp_stop_decode(decoder_);
+    sp_release_decoder_module(decoder_);
+    decoder_ = nullptr;
+}
+
+int DecoderSource::GetFrame(char *buffer, int width, int height)
+{
+    if (sp_vio_get_frame(vps_, buffer, width, height, 500) == 0)
+        return 0;
+    //if get frame fail,the stream is over,restart decode pipeline
+    StopDecode();
+    return StartDecode() ? -1 : 1;
+}
+
+void DecoderSource::Close()
+{
+    StopDecode();
+    if (!vps_)
+        return;
+    sp_vio_close(vps_);
+    sp_release_vio_module(vps_);
+    vps_ = nullptr;
+}
+
+int ReplaySource::Open(const PipelineContext &ctx, int width, int height)
+{
+    path_ = ctx.replay_path;
+    frame_size_ = FRAME_BUFFER_SIZE(width, height);
+    once_ = ctx.replay_once;
+    if (ctx.replay_fps > 0)
+        interval_ = std::chrono::duration_cast<LatencyClock::duration>(std::chrono::duration<double>(1.0 / ctx.replay_fps));
+    next_time_ = LatencyClock::now();
+    next_ = 0;
+
+    struct stat st;
+    if (path_ != "-" && stat(path_.c_str(), &st))
+    {
+        printf("replay %s:%s\n", path_.c_str(), strerror(errno));
+        return -1;
+    }
+    if (path_ != "-" && S_ISREG(st.st_mode))
+    {
+        frames_ = st.st_size / frame_size_;
+        if (!frames_)
+        {
+            printf("replay %s is smaller than one %dx%d nv12 frame\n", path_.c_str(), width, height);
+            return -1;
+        }
+        if (st.st_size % frame_size_)
+            printf("replay %s:ignoring %ld trailing bytes\n", path_.c_str(), (long)(st.st_size % frame_size_));
+        int fd = open(path_.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            printf("replay open %s:%s\n", path_.c_str(), strerror(errno));
+            return -1;
+        }
+        map_size_ = frames_ * frame_size_;
+        void *map = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); //the mapping keeps the file
+        if (map == MAP_FAILED)
+        {
+            printf("replay mmap %s:%s\n", path_.c_str(), strerror(errno));
+            return -1;
+        }
+        madvise(map, map_size_, MADV_SEQUENTIAL);
+        map_ = static_cast<const char *>(map);
+    }
+    else if (path_ != "-" && S_ISDIR(st.st_mode))
+    {
+        DIR *dir = opendir(path_.c_str());
+        if (!dir)
+        {
+            printf("replay opendir %s:%s\n", path_.c_str(), strerror(errno));
+            return -1;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            std::string file = path_ + "/" + entry->d_name;
+            struct stat file_st;
+            if (entry->d_name[0] != '.' && !stat(file.c_str(), &file_st) && S_ISREG(file_st.st_mode))
+                files_.push_back(file);
+        }
+        closedir(dir);
+        std::sort(files_.begin(), files_.end());
+        frames_ = files_.size();
+        if (!frames_)
+        {
+            printf("replay %s has no frame files\n", path_.c_str());
+            return -1;
+        }
+    }
+    else
+    {
+        fd_ = path_ == "-" ? STDIN_FILENO : open(path_.c_str(), O_RDONLY);
+        if (fd_ < 0)
+        {
+            printf("replay open %s:%s\n", path_.c_str(), strerror(errno));
+            return -1;
+        }
+    }
+    printf("replay %s,%zu bytes per frame,%s\n", path_.c_str(), frame_size_,
+           frames_ ? (std::to_string(frames_) + " frames").c_str() : "stream");
+    return 0;
+}
+
+int ReplaySource::ReadFile(const std::string &file, char *buffer)
+{
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        printf("replay open %s:%s\n", file.c_str(), strerror(errno));
+        return -1;
+    }
+    ssize_t size = read(fd, buffer, frame_size_);
+    close(fd);
+    if (size != (ssize_t)frame_size_)
+    {
+        printf("replay %s:expect %zu bytes,got %ld\n", file.c_str(), frame_size_, (long)size);
+        return 1; //skip this file
+    }
+    return 0;
+}
+
+int ReplaySource::ReadStream(char *buffer)
+{
+    size_t got = 0;
+    while (got < frame_size_)
+    {
+        ssize_t size = read(fd_, buffer + got, frame_size_ - got);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            return -1; //end of stream
+        got += size;
+    }
+    return 0;
+}
+
+int ReplaySource::GetFrame(char *buffer, int width, int height)
+{
+    if (interval_.count())
+    {
+        //pace from the previous deadline,so the average rate stays on target
+        std::this_thread::sleep_until(next_time_);
+        next_time_ = std::max(next_time_ + interval_, LatencyClock::now() - interval_);
+    }
+    if (fd_ >= 0)
+        return ReadStream(buffer);
+    if (next_ == frames_)
+    {
+        if (once_)
+            return -1;
+        next_ = 0;
+    }
+    size_t index = next_++;
+    if (map_)
+    {
+        memcpy(buffer, map_ + index * frame_size_, frame_size_);
+        return 0;
+    }
+    return ReadFile(files_[index], buffer);
+}
+
+void ReplaySource::Close()
+{
+    if (map_)
+        munmap(const_cast<char *>(map_), map_size_);
+    map_ = nullptr;
+    if (fd_ >= 0 && fd_ != STDIN_FILENO)
+        close(fd_);
+    fd_ = -1;
+    files_.clear();
+}
+
+int DisplaySink::Open(const PipelineContext &ctx, void *vio)
+{
+    display_ = sp_init_display_module();
+    int ret = sp_start_display(display_, 1, ctx.disp_w, ctx.disp_h); //display on 1 chn,this will not destroy the desktop chn
+    if (vio) //replay has no vio,only the boxes are shown
+        sp_module_bind(vio, SP_MTYPE_VIO, display_, SP_MTYPE_DISPLAY); //bind first
+    ret = sp_start_display(display_, 3, ctx.disp_w, ctx.disp_h); //after bind 1 chn to camera,open 3 chn to draw rectangle
+    if (ret)
+    {
+        printf("display error!\n");
+        if (vio)
+            sp_module_unbind(vio, SP_MTYPE_VIO, display_, SP_MTYPE_DISPLAY);
+        sp_stop_display(display_);
+        sp_release_display_module(display_);
+        display_ = nullptr;
+        return -1;
+    }
+    return 0;
+}
+
+void DisplaySink::Close(void *vio)
+{
+    if (!display_)
+        return;
+    if (vio)
+        sp_module_unbind(vio, SP_MTYPE_VIO, display_, SP_MTYPE_DISPLAY);
+    sp_stop_display(display_);
+    sp_release_display_module(display_);
+    display_ = nullptr;
+}
+
+void DisplaySink::Draw(const DetectionBatch &results)
+{
+    sp_display_draw_rect(display_, 0, 0, 0, 0, 3, 1, 0x00000000, 2); //flush display
+    for (int i = 0; i < results.Size(); i++)
+    {
+        float xmin = results.XMin()[i];
+        float ymin = results.YMin()[i];
+        sp_display_draw_rect(display_, xmin, ymin, results.XMax()[i], results.YMax()[i], 3, 0, 0xFFFF0000, 2); //draw rectangle
+        sp_display_draw_string(display_, xmin, ymin, const_cast<char *>(results.ClassName(i)), 3, 0, 0xFFFF0000, 2); //draw string
+    }
+}
+
+void DisplaySink::Draw(const std::vector<Classification> &results)
+{
+    printf("classification_result: \n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        std::cout << results[i] << std::endl;
+    }
+}
+
+void DisplaySink::Draw(const Segmentation &results)
+{
+    printf("unet_result: results.seg.size():%ld, num_classes:%d, width:%d, height:%d\n", results.seg.size(), results.num_classes, results.width, results.height);
+}
+
+void DisplaySink::Draw(const InstanceSegmentation &results)
+{
+    Draw(results.detections);
+    //the display draws rectangles and strings only,a mask is hatched:every
+    //MASK_HATCH_STEP-th row,its runs of object pixels as 1 px lines
+    for (size_t i = 0; i < results.masks.size(); i++)
+    {
+        const InstanceMask &mask = results.masks[i];
+        for (int y = 0; y < mask.height; y += MASK_HATCH_STEP)
+        {
+            const uint8_t *row = results.pixels.data() + mask.offset + (size_t)y * mask.width;
+            int x = 0;
+            while (x < mask.width)
+            {
+                while (x < mask.width && !row[x])
+                    x++;
+                int start = x;
+                while (x < mask.width && row[x])
+                    x++;
+                if (x > start)
+                    sp_display_draw_rect(display_, mask.x + start, mask.y + y, mask.x + x - 1, mask.y + y, 3, 0, MASK_COLOR, 1);
+            }
+        }
+    }
+}
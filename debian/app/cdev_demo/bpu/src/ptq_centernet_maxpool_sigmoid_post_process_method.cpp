@@ -96,28 +96,16 @@ int filter_func(hbDNNTensor &tensor,
   return 0;
 }
 
-int CenternetMaxPoolSigmoidPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std::vector<Detection> &centernet_det_restuls, bool is_pad_resize) {
+int CenternetMaxPoolSigmoidPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, DetectionBatch &centernet_det_restuls) {
 
   int h_index{2}, w_index{3}, c_index{1};
   int *shape = tensors[0].properties.validShape.dimensionSize;
   int area = shape[h_index] * shape[w_index];
 
-  int origin_height = image_info.m_ori_height;
-  int origin_width = image_info.m_ori_width;
-  float scale_x = 1.0;
-  float scale_y = 1.0;
-  float offset_x = 0.0;
-  float offset_y = 0.0;
-  if (is_pad_resize) {
-    float pad_len = origin_height > origin_width ? origin_height : origin_width;
-    scale_x = pad_len / static_cast<float>(shape[w_index]);
-    scale_y = pad_len / static_cast<float>(shape[h_index]);
-    offset_x = (pad_len - origin_width) / 2;
-    offset_y = (pad_len - origin_height) / 2;
-  } else {
-    scale_x = origin_width / 128.0;
-    scale_y = origin_height / 128.0;
-  }
+  // feature map -> model input as the boxes are pushed,the pipeline maps
+  // them on to the display
+  float scale_x = image_info.m_model_w / static_cast<float>(shape[w_index]);
+  float scale_y = image_info.m_model_h / static_cast<float>(shape[h_index]);
 
   // Determine whether the model contains a dequnatize node by the first tensor
   auto quanti_type = tensors[0].properties.quantiType;
@@ -137,9 +125,8 @@ int CenternetMaxPoolSigmoidPostProcess(hbDNNTensor *tensors, bpu_image_info_t &i
   int topk = node.size() > centernet_maxpool_sigmoid_top_k_ ? centernet_maxpool_sigmoid_top_k_ : node.size();
   if (topk != 0) top_k_helper(node.data(), topk, node.size());
 
-  std::vector<float> reg_x(topk);
-  std::vector<float> reg_y(topk);
-  std::vector<Detection> tmp_box(topk);
+  centernet_det_restuls.Reserve(centernet_det_restuls.Size() + topk);
+  centernet_det_restuls.SetClassNames(&default_ptq_centernet_maxpool_sigmoid_config.class_names);
 
   if (tensors[1].properties.quantiType == hbDNNQuantiType::SCALE) {
     int32_t *wh = reinterpret_cast<int32_t *>(tensors[1].sysMem[0].virAddr);
@@ -166,30 +153,17 @@ int CenternetMaxPoolSigmoidPostProcess(hbDNNTensor *tensors, bpu_image_info_t &i
       float wh_0 = quanti_scale_function(wh[topk_inds], *wh_scale);
       float wh_1 = quanti_scale_function(wh[area + topk_inds], *(wh_scale + 1));
 
-      tmp_box[i].bbox.xmin = topk_xs - wh_0 / 2;
-      tmp_box[i].bbox.xmax = topk_xs + wh_0 / 2;
-      tmp_box[i].bbox.ymin = topk_ys - wh_1 / 2;
-      tmp_box[i].bbox.ymax = topk_ys + wh_1 / 2;
-
-      tmp_box[i].score = topk_score;
-      tmp_box[i].id = topk_clses;
-      tmp_box[i].class_name = default_ptq_centernet_maxpool_sigmoid_config.class_names[topk_clses].c_str();
-      centernet_det_restuls.push_back(tmp_box[i]);
+      centernet_det_restuls.Push(topk_clses,
+                                 (topk_xs - wh_0 / 2) * scale_x,
+                                 (topk_ys - wh_1 / 2) * scale_y,
+                                 (topk_xs + wh_0 / 2) * scale_x,
+                                 (topk_ys + wh_1 / 2) * scale_y,
+                                 topk_score);
     }
   } else {
     printf("centernet unsupport now!\n");
     return -1;
   }
 
-  auto &detections = centernet_det_restuls;
-  int det_num = centernet_det_restuls.size();
-  printf("qat-det.size(): %d\n", det_num);
-  for (int i = 0; i < det_num; i++) {
-    detections[i].bbox.xmin = detections[i].bbox.xmin * scale_x - offset_x;
-    detections[i].bbox.xmax = detections[i].bbox.xmax * scale_x - offset_x;
-    detections[i].bbox.ymin = detections[i].bbox.ymin * scale_y - offset_y;
-    detections[i].bbox.ymax = detections[i].bbox.ymax * scale_y - offset_y;
-  }
-
   return 0;
 }
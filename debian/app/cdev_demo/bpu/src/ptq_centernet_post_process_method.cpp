@@ -1,4 +1,5 @@
 #include "ptq_centernet_post_process_method.hpp"
+#include "bpu_kernels.hpp"
 
 float centernet_score_threshold_ = 0.4;
 int centernet_top_k_ = 50;
@@ -53,15 +54,6 @@ struct DataNode {
   }
 };
 
-static float fastExp(float x) {
-  union {
-    uint32_t i;
-    float f;
-  } v;
-  v.i = (12102203.1616540672f * x + 1064807160.56887296f);
-  return v.f;
-}
-
 // order topK data in node
 static void top_k_helper(DataNode *node, int topk, int len) {
   std::priority_queue<int, std::vector<DataNode>, std::greater<DataNode>> heap;
@@ -488,29 +480,16 @@ int NMSMaxPool2d(hbDNNTensor &tensor,
 }
 
 
-int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std::vector<Detection> &centernet_det_restuls, bool is_pad_resize) {
+int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, DetectionBatch &centernet_det_restuls) {
 
   int h_index{2}, w_index{3}, c_index{1};
   int *shape = tensors[0].properties.validShape.dimensionSize;
   int area = shape[w_index] * shape[w_index];
 
-  int origin_height = image_info.m_ori_height;
-  int origin_width = image_info.m_ori_width;
-  float scale_x = 1.0;
-  float scale_y = 1.0;
-  float offset_x = 0.0;
-  float offset_y = 0.0;
-
-  if (is_pad_resize) {
-    float pad_len = origin_height > origin_width ? origin_height : origin_width;
-    scale_x = pad_len / static_cast<float>(shape[w_index]);
-    scale_y = pad_len / static_cast<float>(shape[h_index]);
-    offset_x = (pad_len - origin_width) / 2;
-    offset_y = (pad_len - origin_height) / 2;
-  } else {
-    scale_x = origin_width / 128.0;
-    scale_y = origin_height / 128.0;
-  }
+  // feature map -> model input as the boxes are pushed,the pipeline maps
+  // them on to the display
+  float scale_x = image_info.m_model_w / static_cast<float>(shape[w_index]);
+  float scale_y = image_info.m_model_h / static_cast<float>(shape[h_index]);
 
   // Determine whether the model contains a dequnatize node by the first tensor
   auto quanti_type = tensors[0].properties.quantiType;
@@ -531,17 +510,15 @@ int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std
   int topk = node.size() > centernet_top_k_ ? centernet_top_k_ : node.size();
   if (topk != 0) top_k_helper(node.data(), topk, node.size());
 
-  std::vector<float> reg_x(topk);
-  std::vector<float> reg_y(topk);
-  std::vector<Detection> tmp_box(topk);
+  centernet_det_restuls.Reserve(centernet_det_restuls.Size() + topk);
+  centernet_det_restuls.SetClassNames(&default_ptq_centernet_config.class_names);
 
   if (quanti_type == hbDNNQuantiType::NONE) {
     float *wh = reinterpret_cast<float *>(tensors[1].sysMem[0].virAddr);
     float *reg = reinterpret_cast<float *>(tensors[2].sysMem[0].virAddr);
 
     for (int i = 0; i < topk; i++) {
-      // float topk_score = 1.0 / (1.0 + exp(-node[i].value));
-      float topk_score = 1.0 / (1.0 + fastExp(-node[i].value));
+      float topk_score = Sigmoid<KernelAccuracy::kFastest>(node[i].value);
       if (topk_score <= centernet_score_threshold_) {
         continue;
       }
@@ -554,15 +531,12 @@ int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std
       topk_xs += reg[topk_inds];
       topk_ys += reg[area + topk_inds];
 
-      tmp_box[i].bbox.xmin = topk_xs - wh[topk_inds] / 2;
-      tmp_box[i].bbox.xmax = topk_xs + wh[topk_inds] / 2;
-      tmp_box[i].bbox.ymin = topk_ys - wh[area + topk_inds] / 2;
-      tmp_box[i].bbox.ymax = topk_ys + wh[area + topk_inds] / 2;
-
-      tmp_box[i].score = topk_score;
-      tmp_box[i].id = topk_clses;
-      tmp_box[i].class_name = default_ptq_centernet_config.class_names[topk_clses].c_str();
-      centernet_det_restuls.push_back(tmp_box[i]);
+      centernet_det_restuls.Push(topk_clses,
+                                 (topk_xs - wh[topk_inds] / 2) * scale_x,
+                                 (topk_ys - wh[area + topk_inds] / 2) * scale_y,
+                                 (topk_xs + wh[topk_inds] / 2) * scale_x,
+                                 (topk_ys + wh[area + topk_inds] / 2) * scale_y,
+                                 topk_score);
     }
 
   } else if (quanti_type == hbDNNQuantiType::SCALE) {
@@ -571,8 +545,7 @@ int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std
     int32_t *wh = reinterpret_cast<int32_t *>(tensors[1].sysMem[0].virAddr);
 
     for (int i = 0; i < topk; i++) {
-      // float topk_score = 1.0 / (1.0 + exp(-node[i].value));
-      float topk_score = 1.0 / (1.0 + fastExp(-node[i].value));
+      float topk_score = Sigmoid<KernelAccuracy::kFastest>(node[i].value);
       if (topk_score <= centernet_score_threshold_) {
         continue;
       }
@@ -593,30 +566,17 @@ int CenternetPostProcess(hbDNNTensor *tensors, bpu_image_info_t &image_info, std
       float wh_1 =
           DequantiScale(wh[area + topk_inds], big_endian, *(scales1 + 1));
 
-      tmp_box[i].bbox.xmin = topk_xs - wh_0 / 2;
-      tmp_box[i].bbox.xmax = topk_xs + wh_0 / 2;
-      tmp_box[i].bbox.ymin = topk_ys - wh_1 / 2;
-      tmp_box[i].bbox.ymax = topk_ys + wh_1 / 2;
-
-      tmp_box[i].score = topk_score;
-      tmp_box[i].id = topk_clses;
-      tmp_box[i].class_name = default_ptq_centernet_config.class_names[topk_clses].c_str();
-      centernet_det_restuls.push_back(tmp_box[i]);
+      centernet_det_restuls.Push(topk_clses,
+                                 (topk_xs - wh_0 / 2) * scale_x,
+                                 (topk_ys - wh_1 / 2) * scale_y,
+                                 (topk_xs + wh_0 / 2) * scale_x,
+                                 (topk_ys + wh_1 / 2) * scale_y,
+                                 topk_score);
     }
   } else {
     printf("centernet unsupport shift dequantzie now!\n");
     return -1;
   }
 
-  auto &detections = centernet_det_restuls;
-  int det_num = centernet_det_restuls.size();
-  printf("qat-det.size(): %d\n", det_num);
-  for (int i = 0; i < det_num; i++) {
-    detections[i].bbox.xmin = detections[i].bbox.xmin * scale_x - offset_x;
-    detections[i].bbox.xmax = detections[i].bbox.xmax * scale_x - offset_x;
-    detections[i].bbox.ymin = detections[i].bbox.ymin * scale_y - offset_y;
-    detections[i].bbox.ymax = detections[i].bbox.ymax * scale_y - offset_y;
-  }
-
   return 0;
 }
@@ -1,20 +1,19 @@
 #include "ptq_ssd_post_process_method.hpp"
 
+#include <mutex>
+
+#include "bpu_kernels.hpp"
+#include "frame_arena.hpp"
+#include "nms_engine.hpp"
+#include "stage_latency.hpp"
+
 std::vector<std::vector<Anchor>> anchors_table_;
+static std::once_flag anchors_table_once_;
 float ssd_score_threshold_ = 0.25;
 float ssd_nms_threshold_ = 0.45;
 bool ssd_is_performance_ = true;
 int ssd_nms_top_k_ = 200;
 
-inline float fastExp(float x) {
-  union {
-    uint32_t i;
-    float f;
-  } v;
-  v.i = (12102203.1616540672f * x + 1064807160.56887296f);
-  return v.f;
-}
-
 
 SSDConfig default_ssd_config = {
     {0.1, 0.1, 0.2, 0.2},
@@ -73,10 +72,41 @@ float DequantiScale(int32_t data,
   return static_cast<float>(r_int32(data, big_endian)) * scale_value;
 }
 
+/**
+ * Softmax score of the best class other than the background,0 when the
+ * background logit is not beaten. exp is monotonic,so the argmax runs on the
+ * logits and only anchors with a foreground winner pay for the exp sum.
+ * @param[out] class_id: class_names index of that class,0 when the
+ *                       background wins. class_names has no entry for the
+ *                       background,the classes after it move down by one.
+ */
+static float ForegroundScore(const float *logits,
+                             int class_num,
+                             int background_index,
+                             int *class_id) {
+  int best = -1;
+  if (background_index > 0) {
+    best = Argmax(logits, background_index);
+  }
+  int rest = background_index + 1;
+  if (rest < class_num) {
+    int id = rest + Argmax(logits + rest, class_num - rest);
+    if (best < 0 || logits[id] > logits[best]) best = id;
+  }
+  if (best < 0 || !(logits[best] > logits[background_index])) {
+    *class_id = 0;
+    return 0;
+  }
+  *class_id = best > background_index ? best - 1 : best;
+  // fastest exp only moves the score a few percent,never the class
+  return Exp<KernelAccuracy::kFastest>(logits[best]) /
+         ExpSum<KernelAccuracy::kFastest>(logits, class_num);
+}
+
 int GetBboxAndScoresQuantiNONE(
     hbDNNTensor *bbox_tensor,
     hbDNNTensor *cls_tensor,
-    std::vector<Detection> &dets,
+    DetectionBatch &dets,
     std::vector<Anchor> &anchors,
     int class_num,
     bpu_image_info_t &image_info) {
@@ -102,47 +132,15 @@ int GetBboxAndScoresQuantiNONE(
   auto *raw_cls_data = reinterpret_cast<float *>(cls_tensor->sysMem[0].virAddr);
   auto *raw_box_data =
       reinterpret_cast<float *>(bbox_tensor->sysMem[0].virAddr);
+  dets.Reserve(dets.Size() + box_num);
 
   for (int i = 0; i < box_num; i++) {
     uint32_t res_id_cur_anchor = i * class_num;
-    // get softmax sum
-    double sum = 0;
     int max_id = 0;
-    // TODO(@horizon.ai): fastExp only affect the final score value
-    // confirm whether it affects the accuracy
-    double background_score;
-    bool is_performance_ = true;
-    if (is_performance_) {
-      background_score = fastExp(
-          raw_cls_data[res_id_cur_anchor + default_ssd_config.background_index]);
-    } else {
-      background_score = std::exp(
-          raw_cls_data[res_id_cur_anchor + default_ssd_config.background_index]);
-    }
-
-    double max_score = 0;
-    for (int cls = 0; cls < class_num; ++cls) {
-      float cls_score;
-      if (is_performance_) {
-        cls_score = fastExp(raw_cls_data[res_id_cur_anchor + cls]);
-      } else {
-        cls_score = std::exp(raw_cls_data[res_id_cur_anchor + cls]);
-      }
-      /* 1. scores should be larger than background score, or else will not be
-      selected
-      2. For Location for class_name, to add background to class-names list when
-      background is not lastest
-      3. For ssd_mobilenetv1_300x300_nv12.bin, background_index is 0, the value
-      can be modified according to different model*/
-      if (cls != default_ssd_config.background_index && cls_score > max_score &&
-          cls_score > background_score) {
-        max_id = cls;
-        max_score = cls_score;
-      }
-      sum += cls_score;
-    }
-    // get softmax score
-    max_score = max_score / sum;
+    float max_score = ForegroundScore(raw_cls_data + res_id_cur_anchor,
+                                      class_num,
+                                      default_ssd_config.background_index,
+                                      &max_id);
 
     if (max_score <= ssd_score_threshold_) {
       continue;
@@ -168,22 +166,16 @@ int GetBboxAndScoresQuantiNONE(
     auto decode_w = std::exp(default_ssd_config.std[2] * dw) * prior_w;
     auto decode_h = std::exp(default_ssd_config.std[3] * dh) * prior_h;
 
-    auto xmin_org = (decode_x - decode_w * 0.5) * image_info.m_ori_width;
-    auto ymin_org = (decode_y - decode_h * 0.5) * image_info.m_ori_height;
-    auto xmax_org = (decode_x + decode_w * 0.5) * image_info.m_ori_width;
-    auto ymax_org = (decode_y + decode_h * 0.5) * image_info.m_ori_height;
+    // model input pixels,the pipeline maps and clips them to the display
+    auto box_xmin = (decode_x - decode_w * 0.5) * image_info.m_model_w;
+    auto box_ymin = (decode_y - decode_h * 0.5) * image_info.m_model_h;
+    auto box_xmax = (decode_x + decode_w * 0.5) * image_info.m_model_w;
+    auto box_ymax = (decode_y + decode_h * 0.5) * image_info.m_model_h;
 
-    xmin_org = std::max(xmin_org, 0.0);
-    xmax_org = std::min(xmax_org, image_info.m_ori_width - 1.0);
-    ymin_org = std::max(ymin_org, 0.0);
-    ymax_org = std::min(ymax_org, image_info.m_ori_height - 1.0);
+    if (box_xmax <= 0 || box_ymax <= 0) continue;
+    if (box_xmin > box_xmax || box_ymin > box_ymax) continue;
 
-    if (xmax_org <= 0 || ymax_org <= 0) continue;
-    if (xmin_org > xmax_org || ymin_org > ymax_org) continue;
-
-    Bbox bbox(xmin_org, ymin_org, xmax_org, ymax_org);
-    dets.emplace_back(Detection(
-        (int)max_id, max_score, bbox, default_ssd_config.class_names[max_id].c_str()));
+    dets.Push(max_id, box_xmin, box_ymin, box_xmax, box_ymax, max_score);
   }
   return 0;
 }
@@ -191,7 +183,7 @@ int GetBboxAndScoresQuantiNONE(
 int GetBboxAndScoresQuantiSCALE(
     hbDNNTensor *bbox_tensor,
     hbDNNTensor *cls_tensor,
-    std::vector<Detection> &dets,
+    DetectionBatch &dets,
     std::vector<Anchor> &anchors,
     int class_num,
     bpu_image_info_t &image_info) {
@@ -222,32 +214,21 @@ int GetBboxAndScoresQuantiSCALE(
 
   auto stride = cls_c_valid / class_num;
   auto bbox_num_pred = bbox_c_valid / stride;
+  FrameArena &arena = FrameArena::ThisThread();
+  ArenaScope scope(arena);
+  float *cls_logits = arena.Alloc<float>(class_num);
+  dets.Reserve(dets.Size() + bbox_h * bbox_w * stride);
 
   for (int h = 0; h < bbox_h; ++h) {
     for (int w = 0; w < bbox_w; ++w) {
       for (int k = 0; k < stride; ++k) {
         int32_t *cur_cls_data = cls_data + k * class_num;
         float *cur_cls_scale = cls_scale + k * class_num;
-        float tmp = DequantiScale(cur_cls_data[0], false, cur_cls_scale[0]);
-        bool is_performance_ = true;
-        double background_score =
-            is_performance_ ? fastExp(tmp) : std::exp(tmp);
-        double sum = 0;
+        DequantizeScaled(cur_cls_data, cur_cls_scale, cls_logits, class_num);
         int max_id = 0;
-        double max_score = 0;
-        for (int index = 0; index < class_num; ++index) {
-          tmp = DequantiScale(cur_cls_data[index], false, cur_cls_scale[index]);
-
-          float cls_score = is_performance_ ? fastExp(tmp) : std::exp(tmp);
-
-          sum += cls_score;
-          if (index != 0 && cls_score > max_score &&
-              cls_score > background_score) {
-            max_id = index - 1;
-            max_score = cls_score;
-          }
-        }
-        max_score = max_score / sum;
+        float max_score =
+            ForegroundScore(cls_logits, class_num,
+                            default_ssd_config.background_index, &max_id);
 
         if (max_score <= ssd_score_threshold_) {
           continue;
@@ -275,24 +256,16 @@ int GetBboxAndScoresQuantiSCALE(
         auto decode_w = std::exp(default_ssd_config.std[2] * dw) * prior_w;
         auto decode_h = std::exp(default_ssd_config.std[3] * dh) * prior_h;
 
-        auto xmin_org = (decode_x - decode_w * 0.5) * image_info.m_ori_width;
-        auto ymin_org = (decode_y - decode_h * 0.5) * image_info.m_ori_height;
-        auto xmax_org = (decode_x + decode_w * 0.5) * image_info.m_ori_width;
-        auto ymax_org = (decode_y + decode_h * 0.5) * image_info.m_ori_height;
+        // model input pixels,the pipeline maps and clips them to the display
+        auto box_xmin = (decode_x - decode_w * 0.5) * image_info.m_model_w;
+        auto box_ymin = (decode_y - decode_h * 0.5) * image_info.m_model_h;
+        auto box_xmax = (decode_x + decode_w * 0.5) * image_info.m_model_w;
+        auto box_ymax = (decode_y + decode_h * 0.5) * image_info.m_model_h;
 
-        xmin_org = std::max(xmin_org, 0.0);
-        xmax_org = std::min(xmax_org, image_info.m_ori_width - 1.0);
-        ymin_org = std::max(ymin_org, 0.0);
-        ymax_org = std::min(ymax_org, image_info.m_ori_height - 1.0);
+        if (box_xmax <= 0 || box_ymax <= 0) continue;
+        if (box_xmin > box_xmax || box_ymin > box_ymax) continue;
 
-        if (xmax_org <= 0 || ymax_org <= 0) continue;
-        if (xmin_org > xmax_org || ymin_org > ymax_org) continue;
-
-        Bbox bbox(xmin_org, ymin_org, xmax_org, ymax_org);
-        dets.emplace_back(Detection((int)max_id,
-                                    max_score,
-                                    bbox,
-                                    default_ssd_config.class_names[max_id].c_str()));
+        dets.Push(max_id, box_xmin, box_ymin, box_xmax, box_ymax, max_score);
       }
       bbox_data = bbox_data + bbox_c_aligned;
       cls_data = cls_data + cls_c_aligned;
@@ -303,7 +276,7 @@ int GetBboxAndScoresQuantiSCALE(
 
 int GetBboxAndScores(hbDNNTensor *bbox_tensor,
                                               hbDNNTensor *cls_tensor,
-                                              std::vector<Detection> &dets,
+                                              DetectionBatch &dets,
                                               std::vector<Anchor> &anchors,
                                               int class_num,
                                               bpu_image_info_t &image_info) {
@@ -320,82 +293,37 @@ int GetBboxAndScores(hbDNNTensor *bbox_tensor,
   }
 }
 
-#define NMS_MAX_INPUT (400)
-void ssd_nms(std::vector<Detection> &input,
+// from this many candidates on nms buckets them in a spatial grid
+#define NMS_GRID_CANDIDATES (512)
+void ssd_nms(const DetectionBatch &input,
          float iou_threshold,
          int top_k,
-         std::vector<Detection> &result,
+         DetectionBatch &result,
          bool suppress) {
-  // sort order by score desc
-  std::stable_sort(input.begin(), input.end(), std::greater<Detection>());
-  if (input.size() > NMS_MAX_INPUT) {
-    input.resize(NMS_MAX_INPUT);
-  }
-
-  std::vector<bool> skip(input.size(), false);
-
-  // pre-calculate boxes area
-  std::vector<float> areas;
-  areas.reserve(input.size());
-  for (size_t i = 0; i < input.size(); i++) {
-    float width = input[i].bbox.xmax - input[i].bbox.xmin;
-    float height = input[i].bbox.ymax - input[i].bbox.ymin;
-    areas.push_back(width * height);
-  }
-
-  int count = 0;
-  for (size_t i = 0; count < top_k && i < skip.size(); i++) {
-    if (skip[i]) {
-      continue;
-    }
-    skip[i] = true;
-    ++count;
-
-    for (size_t j = i + 1; j < skip.size(); ++j) {
-      if (skip[j]) {
-        continue;
-      }
-      if (suppress == false) {
-        if (input[i].id != input[j].id) {
-          continue;
-        }
-      }
-
-      // intersection area
-      float xx1 = std::max(input[i].bbox.xmin, input[j].bbox.xmin);
-      float yy1 = std::max(input[i].bbox.ymin, input[j].bbox.ymin);
-      float xx2 = std::min(input[i].bbox.xmax, input[j].bbox.xmax);
-      float yy2 = std::min(input[i].bbox.ymax, input[j].bbox.ymax);
-
-      if (xx2 > xx1 && yy2 > yy1) {
-        float area_intersection = (xx2 - xx1) * (yy2 - yy1);
-        float iou_ratio =
-            area_intersection / (areas[j] + areas[i] - area_intersection);
-        if (iou_ratio > iou_threshold) {
-          skip[j] = true;
-        }
-      }
-    }
-    result.push_back(input[i]);
-  }
+  NmsParams params = {iou_threshold, top_k, suppress,
+                      NMS_GRID_CANDIDATES};
+  NmsBatch(input, params, result);
 }
 
 int SSDPostProcess(hbDNNTensor *tensors,
                                          bpu_image_info_t &image_info,
-                                         std::vector<Detection> &ssd_det_restuls) {
+                                         DetectionBatch &ssd_det_restuls) {
+  LatencyClock::time_point start = LatencyClock::now();
   int layer_num = default_ssd_config.step.size();
-  if (anchors_table_.empty()) {
-    // Note: note thread safe
+  // post processing workers may get here at the same time
+  std::call_once(anchors_table_once_, [&] {
     anchors_table_.resize(layer_num);
     for (int i = 0; i < layer_num; i++) {
-      std::vector<Anchor> &anchors = anchors_table_[i];
       int height = tensors[i * 2].properties.alignedShape.dimensionSize[1];
       int width = tensors[i * 2].properties.alignedShape.dimensionSize[2];
       SsdAnchors(anchors_table_[i], i, height, width);
     }
-  }
+  });
 
-  std::vector<Detection> dets;
+  // kept per post thread,Clear() keeps the capacity of earlier frames
+  static thread_local DetectionBatch dets;
+  dets.Clear();
+  dets.SetClassNames(&default_ssd_config.class_names);
   for (int i = 0; i < layer_num; i++) {
     std::vector<Anchor> &anchors = anchors_table_[i];
     GetBboxAndScores(&tensors[i * 2],
@@ -405,6 +333,8 @@ int SSDPostProcess(hbDNNTensor *tensors,
                      default_ssd_config.class_num + 1,
                      image_info);
   }
+  start = RecordStage(kStageTensorParse, start);
   ssd_nms(dets, ssd_nms_threshold_, ssd_nms_top_k_, ssd_det_restuls, false);
+  RecordStage(kStageNms, start);
   return 0;
 }
@@ -0,0 +1,118 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: per stage latency histograms of the bpu sample pipeline
+ ***************************************************************************/
+#include <stdio.h>
+#include "stage_latency.hpp"
+
+static const char *stage_names[kStageCount] = {
+    "capture", "preprocess", "bpu_submit", "bpu_done", "tensor_parse", "nms", "mask", "draw", "end_to_end"};
+
+int LatencyHistogram::BucketIndex(uint64_t us)
+{
+    if (us < (uint64_t)kSubBuckets)
+        return (int)us; //first power of two range is exact
+    int magnitude = 63 - __builtin_clzll(us); //floor(log2(us)),>= kSubBucketBits
+    int shift = magnitude - kSubBucketBits;
+    int sub = (int)(us >> shift) - kSubBuckets; //top bits below the leading one
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index)
+{
+    if (index < kSubBuckets)
+        return index;
+    int shift = index / kSubBuckets - 1;
+    uint64_t sub = index % kSubBuckets + kSubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t us)
+{
+    buckets_[BucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(us, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (us > max && !max_.compare_exchange_weak(max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::Percentile(double quantile) const
+{
+    uint64_t total = count();
+    if (!total)
+        return 0;
+    uint64_t rank = (uint64_t)(quantile * total + 0.5);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++)
+    {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            uint64_t upper = BucketUpperBound(i);
+            return upper < max() ? upper : max();
+        }
+    }
+    return max(); //samples recorded while we were walking the buckets
+}
+
+void LatencyHistogram::Reset()
+{
+    for (int i = 0; i < kBuckets; i++)
+    {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+const char *StageLatency::StageName(LatencyStage stage)
+{
+    return stage_names[stage];
+}
+
+StageLatency &StageLatency::Get()
+{
+    static StageLatency instance;
+    return instance;
+}
+
+void StageLatency::Record(LatencyStage stage, LatencyClock::time_point start, LatencyClock::time_point end)
+{
+    if (frozen_.load(std::memory_order_relaxed))
+        return;
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    histograms_[stage].Record(us > 0 ? us : 0);
+}
+
+void StageLatency::Dump(const char *title)
+{
+    printf("==== %s stage latency(us) ====\n", title);
+    printf("%-13s %8s %8s %8s %8s %8s %8s\n", "stage", "count", "mean", "p50", "p90", "p99", "max");
+    for (int i = 0; i < kStageCount; i++)
+    {
+        const LatencyHistogram &histogram = histograms_[i];
+        uint64_t count = histogram.count();
+        if (!count)
+            continue;
+        printf("%-13s %8llu %8llu %8llu %8llu %8llu %8llu\n", stage_names[i], (unsigned long long)count,
+               (unsigned long long)(histogram.sum() / count),
+               (unsigned long long)histogram.Percentile(0.5), (unsigned long long)histogram.Percentile(0.9),
+               (unsigned long long)histogram.Percentile(0.99), (unsigned long long)histogram.max());
+    }
+}
+
+void StageLatency::Reset()
+{
+    for (int i = 0; i < kStageCount; i++)
+    {
+        histograms_[i].Reset();
+    }
+    frozen_.store(false, std::memory_order_relaxed);
+}
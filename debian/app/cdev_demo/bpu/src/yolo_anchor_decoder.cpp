@@ -0,0 +1,260 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: one decoder for the anchor based yolo heads (yolov3,yolov5
+ *               s/x,yolov5 v6/v7),specialized at compile time per variant
+ ***************************************************************************/
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include "yolo_anchor_decoder.hpp"
+#include "frame_arena.hpp"
+
+/**
+ * Valid grid size of one head.
+ * @return 0 if success
+ */
+static int HeadSize(const hbDNNTensor *tensor, int *height, int *width)
+{
+    const hbDNNTensorProperties &properties = tensor->properties;
+    if (properties.tensorLayout == HB_DNN_LAYOUT_NHWC)
+    {
+        *height = properties.validShape.dimensionSize[1];
+        *width = properties.validShape.dimensionSize[2];
+        return 0;
+    }
+    if (properties.tensorLayout == HB_DNN_LAYOUT_NCHW)
+    {
+        *height = properties.validShape.dimensionSize[2];
+        *width = properties.validShape.dimensionSize[3];
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * Phase 1:collect the anchors whose objectness alone can pass the score
+ * threshold. confidence = sigmoid(objness) * sigmoid(class) and the class
+ * term is at most 1,so comparing the raw objness against the logit
+ * threshold of its anchor drops >99% of the anchors without any exp. For
+ * SCALE quantized outputs the threshold is an integer and nothing is
+ * dequantized here. One anchor slot and grid row at a time its objness
+ * values are view.WStep() elements apart (1 for NCHW),the compaction is
+ * branch free so the loop only streams through them.
+ * @return number of candidates written to candidates,cell * anchor_num + k
+ */
+template <class T, class Threshold, class View>
+static int ScanObjness(const T *data, const View &view, int height, int width, int anchor_num, int num_pred,
+                       const Threshold *thresholds, int *candidates)
+{
+    int count = 0;
+    const int w_step = view.WStep();
+    for (int k = 0; k < anchor_num; k++)
+    {
+        const Threshold threshold = thresholds[k];
+        for (int h = 0; h < height; h++)
+        {
+            const T *objness = data + view.Offset(h, 0, k * num_pred + 4);
+            int cell = h * width;
+            int w = 0;
+            for (; w + 4 <= width; w += 4)
+            {
+                T o0 = objness[(w + 0) * w_step];
+                T o1 = objness[(w + 1) * w_step];
+                T o2 = objness[(w + 2) * w_step];
+                T o3 = objness[(w + 3) * w_step];
+                candidates[count] = (cell + w + 0) * anchor_num + k;
+                count += o0 >= threshold;
+                candidates[count] = (cell + w + 1) * anchor_num + k;
+                count += o1 >= threshold;
+                candidates[count] = (cell + w + 2) * anchor_num + k;
+                count += o2 >= threshold;
+                candidates[count] = (cell + w + 3) * anchor_num + k;
+                count += o3 >= threshold;
+            }
+            for (; w < width; w++)
+            {
+                candidates[count] = (cell + w) * anchor_num + k;
+                count += objness[w * w_step] >= threshold;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * One head of float (scale nullptr) or SCALE quantized T outputs read in
+ * place through view,only the candidates of phase 1 are dequantized.
+ */
+template <class BoxPolicy, class T, bool kPlanar>
+static void ParseLayer(const YoloAnchorConfig &config,
+                       float score_threshold,
+                       const T *data,
+                       const float *scale,
+                       const HeadView<kPlanar> &view,
+                       const YoloDecodePlan &plan,
+                       int layer,
+                       DetectionBatch &results)
+{
+    typedef typename std::conditional<std::is_floating_point<T>::value, float, int32_t>::type Threshold;
+    int num_classes = config.class_num;
+    int num_pred = config.class_num + 4 + 1 + config.mask_dim;
+    const YoloDecodeLayer &layer_plan = plan.layers[layer];
+    int height = layer_plan.height;
+    int width = layer_plan.width;
+
+    int anchor_num = layer_plan.anchor_num;
+    int anchor_count = height * width * anchor_num;
+    const int c_step = view.CStep();
+    //sigmoid(x) >= threshold <=> x >= log(threshold / (1 - threshold))
+    float objness_logit_threshold = std::log(score_threshold / (1 - score_threshold));
+    FrameArena &arena = FrameArena::ThisThread();
+    ArenaScope scope(arena);
+    Threshold *thresholds = arena.Alloc<Threshold>(anchor_num);
+    for (int k = 0; k < anchor_num; k++)
+    {
+        thresholds[k] = scale ? QuantizedThreshold(objness_logit_threshold, scale[k * num_pred + 4])
+                              : objness_logit_threshold;
+    }
+
+    //phase 1,anchor indices grouped by anchor slot
+    int *candidates = arena.Alloc<int>(anchor_count + 1); //the compaction writes one past the last candidate
+    int count = ScanObjness(data, view, height, width, anchor_num, num_pred, thresholds, candidates);
+    results.Reserve(results.Size() + count, config.mask_dim);
+    results.SetClassNames(&config.class_names);
+
+    //phase 2,class argmax,sigmoid and box decode of the survivors only,
+    //the plan tables give model input pixels
+    for (int c = 0; c < count; c++)
+    {
+        int index = candidates[c];
+        int k = index % anchor_num;
+        int cell = index / anchor_num;
+        int h = cell / width;
+        int w = cell % width;
+        const T *cur_data = data + view.Offset(h, w, k * num_pred);
+        const float *cur_scale = scale ? scale + k * num_pred : nullptr;
+
+        float class_logit;
+        int id = kPlanar ? ArgmaxDequantizedStrided(cur_data + 5 * c_step, c_step, cur_scale ? cur_scale + 5 : nullptr, num_classes, &class_logit)
+                         : ArgmaxDequantized(cur_data + 5, cur_scale ? cur_scale + 5 : nullptr, num_classes, &class_logit);
+        float confidence = Sigmoid<KernelAccuracy::kExact>(DequantizeAt(cur_data, cur_scale, 4, c_step)) * Sigmoid<KernelAccuracy::kExact>(class_logit);
+        if (confidence < score_threshold)
+        {
+            continue;
+        }
+
+        float box_center_x = layer_plan.grid_x[w] + layer_plan.xy_gain_x * Sigmoid<KernelAccuracy::kExact>(DequantizeAt(cur_data, cur_scale, 0, c_step));
+        float box_center_y = layer_plan.grid_y[h] + layer_plan.xy_gain_y * Sigmoid<KernelAccuracy::kExact>(DequantizeAt(cur_data, cur_scale, 1, c_step));
+        float box_half_x = layer_plan.anchor_half_w[k] * BoxPolicy::Size(DequantizeAt(cur_data, cur_scale, 2, c_step));
+        float box_half_y = layer_plan.anchor_half_h[k] * BoxPolicy::Size(DequantizeAt(cur_data, cur_scale, 3, c_step));
+
+        float xmin = box_center_x - box_half_x;
+        float ymin = box_center_y - box_half_y;
+        float xmax = box_center_x + box_half_x;
+        float ymax = box_center_y + box_half_y;
+        //nothing of it inside the model input,whatever the pre processing was
+        if (xmax <= 0.0f || ymax <= 0.0f)
+        {
+            continue;
+        }
+        if (xmin > xmax || ymin > ymax)
+        {
+            continue;
+        }
+
+        int detection = results.Push(id, xmin, ymin, xmax, ymax, confidence);
+        if (config.mask_dim > 0)
+        {
+            const T *mask_data = cur_data + (5 + num_classes) * c_step;
+            const float *mask_scale = cur_scale ? cur_scale + 5 + num_classes : nullptr;
+            float *coefficients = results.Extra(detection);
+            for (int i = 0; i < config.mask_dim; i++)
+            {
+                coefficients[i] = DequantizeAt(mask_data, mask_scale, i, c_step);
+            }
+        }
+    }
+}
+
+/**
+ * Pick the in place view of tensor's layout,NCHW and NHWC decode with their
+ * own instantiation.
+ */
+template <class BoxPolicy, class T>
+static void ParseHead(const YoloAnchorConfig &config,
+                      float score_threshold,
+                      const T *data,
+                      const float *scale,
+                      const hbDNNTensor *tensor,
+                      const YoloDecodePlan &plan,
+                      int layer,
+                      DetectionBatch &results)
+{
+    HeadView<false> nhwc;
+    HeadView<true> nchw;
+    if (nhwc.Init(tensor->properties, sizeof(T)))
+        ParseLayer<BoxPolicy>(config, score_threshold, data, scale, nhwc, plan, layer, results);
+    else if (nchw.Init(tensor->properties, sizeof(T)))
+        ParseLayer<BoxPolicy>(config, score_threshold, data, scale, nchw, plan, layer, results);
+    else
+        printf("yolo unsupported tensor layout: %d\n", tensor->properties.tensorLayout);
+}
+
+template <class BoxPolicy>
+int AnchorYoloDecoder<BoxPolicy>::BuildPlan(const YoloAnchorConfig &config, const hbDNNTensor *tensors,
+                                            const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+{
+    size_t layer_num = config.strides.size();
+    std::vector<int> heights(layer_num), widths(layer_num);
+    for (size_t i = 0; i < layer_num; i++)
+    {
+        if (HeadSize(&tensors[i], &heights[i], &widths[i]) != 0)
+        {
+            printf("yolo unsupported tensor layout: %d\n", tensors[i].properties.tensorLayout);
+            return -1;
+        }
+    }
+    return BuildYoloDecodePlan(image_info, config.strides, config.anchors_table, heights, widths, BoxPolicy::Coding(), plan);
+}
+
+template <class BoxPolicy>
+void AnchorYoloDecoder<BoxPolicy>::ParseTensor(const YoloAnchorConfig &config, float score_threshold,
+                                               const hbDNNTensor *tensor, const YoloDecodePlan &plan, int layer,
+                                               DetectionBatch &results)
+{
+    const hbDNNTensorProperties &properties = tensor->properties;
+    void *data = tensor->sysMem[0].virAddr;
+    if (properties.quantiType == NONE)
+    {
+        ParseHead<BoxPolicy>(config, score_threshold, reinterpret_cast<float *>(data), nullptr, tensor, plan, layer, results);
+        return;
+    }
+    if (properties.quantiType != SCALE)
+    {
+        printf("yolo unsupported quanti_type: %d\n", properties.quantiType);
+        return;
+    }
+    const float *scale = properties.scale.scaleData;
+    switch (properties.tensorType)
+    {
+    case HB_DNN_TENSOR_TYPE_S8:
+        ParseHead<BoxPolicy>(config, score_threshold, reinterpret_cast<int8_t *>(data), scale, tensor, plan, layer, results);
+        break;
+    case HB_DNN_TENSOR_TYPE_S16:
+        ParseHead<BoxPolicy>(config, score_threshold, reinterpret_cast<int16_t *>(data), scale, tensor, plan, layer, results);
+        break;
+    case HB_DNN_TENSOR_TYPE_S32:
+        ParseHead<BoxPolicy>(config, score_threshold, reinterpret_cast<int32_t *>(data), scale, tensor, plan, layer, results);
+        break;
+    default:
+        printf("yolo unsupported quantized tensor_type: %d\n", properties.tensorType);
+        break;
+    }
+}
+
+//yolov5s/x,the yolov5 v6/v7 exports and yolov5 seg share the yolov5 box coding
+template struct AnchorYoloDecoder<Yolov5BoxPolicy>;
+template struct AnchorYoloDecoder<Yolov3BoxPolicy>;
@@ -0,0 +1,57 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: per model decode tables of anchor based yolo heads,built
+ *               once per resolution so the box decode is multiply-adds only
+ ***************************************************************************/
+#include <stdio.h>
+#include "yolo_decode_plan.hpp"
+
+int BuildYoloDecodePlan(const bpu_image_info_t &image_info,
+                        const std::vector<int> &strides,
+                        const std::vector<std::vector<std::pair<double, double>>> &anchors_table,
+                        const std::vector<int> &heights,
+                        const std::vector<int> &widths,
+                        const YoloBoxCoding &coding,
+                        YoloDecodePlan &plan)
+{
+    size_t layer_num = strides.size();
+    if (anchors_table.size() != layer_num || heights.size() != layer_num || widths.size() != layer_num)
+    {
+        printf("yolo decode plan: %zu strides,%zu anchor sets,%zu heads\n", layer_num, anchors_table.size(), heights.size());
+        return -1;
+    }
+    plan.image_info = image_info;
+    plan.layers.resize(layer_num);
+    for (size_t i = 0; i < layer_num; i++)
+    {
+        YoloDecodeLayer &layer = plan.layers[i];
+        double stride = strides[i];
+        const std::vector<std::pair<double, double>> &anchors = anchors_table[i];
+        layer.height = heights[i];
+        layer.width = widths[i];
+        layer.anchor_num = anchors.size();
+        layer.xy_gain_x = coding.xy_scale * stride;
+        layer.xy_gain_y = coding.xy_scale * stride;
+        layer.grid_x.resize(layer.width);
+        for (int w = 0; w < layer.width; w++)
+        {
+            layer.grid_x[w] = (coding.xy_offset + w) * stride;
+        }
+        layer.grid_y.resize(layer.height);
+        for (int h = 0; h < layer.height; h++)
+        {
+            layer.grid_y[h] = (coding.xy_offset + h) * stride;
+        }
+        double size_scale = coding.size_scale * (coding.anchors_in_grid ? stride : 1.0) / 2.0;
+        layer.anchor_half_w.resize(layer.anchor_num);
+        layer.anchor_half_h.resize(layer.anchor_num);
+        for (int k = 0; k < layer.anchor_num; k++)
+        {
+            layer.anchor_half_w[k] = anchors[k].first * size_scale;
+            layer.anchor_half_h[k] = anchors[k].second * size_scale;
+        }
+    }
+    return 0;
+}
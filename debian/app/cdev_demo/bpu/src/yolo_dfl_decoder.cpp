@@ -0,0 +1,324 @@
+/***************************************************************************
+ * @COPYRIGHT NOTICE
+ * @Copyright 2023 Horizon Robotics, Inc.
+ * @All rights reserved.
+ * @Description: decoder of the anchor free yolo heads (yolov8 style),
+ *               per class sigmoid scores and distribution focal loss boxes
+ ***************************************************************************/
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include "yolo_dfl_decoder.hpp"
+#include "frame_arena.hpp"
+
+/**
+ * Valid grid size and channel count of one output.
+ * @return 0 if success
+ */
+static int HeadShape(const hbDNNTensor *tensor, int *height, int *width, int *channels)
+{
+    const hbDNNTensorProperties &properties = tensor->properties;
+    if (properties.tensorLayout == HB_DNN_LAYOUT_NHWC)
+    {
+        *height = properties.validShape.dimensionSize[1];
+        *width = properties.validShape.dimensionSize[2];
+        *channels = properties.validShape.dimensionSize[3];
+        return 0;
+    }
+    if (properties.tensorLayout == HB_DNN_LAYOUT_NCHW)
+    {
+        *height = properties.validShape.dimensionSize[2];
+        *width = properties.validShape.dimensionSize[3];
+        *channels = properties.validShape.dimensionSize[1];
+        return 0;
+    }
+    return -1;
+}
+
+template <class Visitor, class T>
+static bool VisitLayout(const T *data, const float *scale, const hbDNNTensor *tensor, Visitor &visitor)
+{
+    HeadView<false> nhwc;
+    HeadView<true> nchw;
+    if (nhwc.Init(tensor->properties, sizeof(T)))
+        visitor(data, scale, nhwc);
+    else if (nchw.Init(tensor->properties, sizeof(T)))
+        visitor(data, scale, nchw);
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Call visitor(data, scale, view) with the element type and the in place
+ * view of tensor,scale is nullptr for float outputs. The class and the box
+ * output of a head are visited separately,so their types and layouts do
+ * not multiply into each other's instantiations.
+ * @return false if the type or layout is not supported
+ */
+template <class Visitor>
+static bool VisitTensor(const hbDNNTensor *tensor, Visitor &visitor)
+{
+    const hbDNNTensorProperties &properties = tensor->properties;
+    void *data = tensor->sysMem[0].virAddr;
+    if (properties.quantiType == NONE)
+        return VisitLayout(reinterpret_cast<const float *>(data), nullptr, tensor, visitor);
+    if (properties.quantiType != SCALE)
+        return false;
+    const float *scale = properties.scale.scaleData;
+    switch (properties.tensorType)
+    {
+    case HB_DNN_TENSOR_TYPE_S8:
+        return VisitLayout(reinterpret_cast<const int8_t *>(data), scale, tensor, visitor);
+    case HB_DNN_TENSOR_TYPE_S16:
+        return VisitLayout(reinterpret_cast<const int16_t *>(data), scale, tensor, visitor);
+    case HB_DNN_TENSOR_TYPE_S32:
+        return VisitLayout(reinterpret_cast<const int32_t *>(data), scale, tensor, visitor);
+    default:
+        return false;
+    }
+}
+
+/**
+ * Phase 1:best class of every cell,kept if its logit reaches the logit of
+ * the score threshold. The compaction is branch free,cells/ids/logits get
+ * the count candidates in cell order.
+ */
+struct ClassScan
+{
+    int height;
+    int width;
+    int num_classes;
+    float logit_threshold;
+    int *cells;
+    int *ids;
+    float *logits;
+    int count;
+
+    //NHWC,the classes of a cell are contiguous
+    template <class T>
+    void operator()(const T *data, const float *scale, const HeadView<false> &view)
+    {
+        count = 0;
+        for (int h = 0; h < height; h++)
+        {
+            for (int w = 0; w < width; w++)
+            {
+                float logit;
+                int id = ArgmaxDequantized(data + view.Offset(h, w, 0), scale, num_classes, &logit);
+                cells[count] = h * width + w;
+                ids[count] = id;
+                logits[count] = logit;
+                count += logit >= logit_threshold;
+            }
+        }
+    }
+
+    //NCHW,running maximum over the class planes in ids/logits,then compacted
+    //in place,the write index never passes the read index
+    template <class T>
+    void operator()(const T *data, const float *scale, const HeadView<true> &view)
+    {
+        const int c_step = view.CStep();
+        for (int c = 0; c < num_classes; c++)
+        {
+            float class_scale = scale ? scale[c] : 1.0f;
+            for (int h = 0; h < height; h++)
+            {
+                const T *row = data + view.Offset(h, 0, 0) + c * c_step;
+                int cell = h * width;
+                for (int w = 0; w < width; w++, cell++)
+                {
+                    float value = row[w] * class_scale;
+                    if (c == 0 || value > logits[cell])
+                    {
+                        logits[cell] = value;
+                        ids[cell] = c;
+                    }
+                }
+            }
+        }
+        count = 0;
+        int cell_num = height * width;
+        for (int cell = 0; cell < cell_num; cell++)
+        {
+            float logit = logits[cell];
+            cells[count] = cell;
+            ids[count] = ids[cell];
+            logits[count] = logit;
+            count += logit >= logit_threshold;
+        }
+    }
+};
+
+/**
+ * The 4 * reg_max bins of one cell as float,float NHWC outputs are used in
+ * place.
+ */
+template <class T, bool kPlanar>
+static const float *LoadBins(const T *data, const float *scale, const HeadView<kPlanar> &view, int n, float *bins)
+{
+    const int c_step = view.CStep();
+    for (int i = 0; i < n; i++)
+    {
+        bins[i] = DequantizeAt(data, scale, i, c_step);
+    }
+    return bins;
+}
+
+template <class T>
+static const float *LoadBins(const T *data, const float *scale, const HeadView<false> &view, int n, float *bins)
+{
+    if (!scale)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            bins[i] = data[i];
+        }
+        return bins;
+    }
+    DequantizeScaled(data, scale, bins, n);
+    return bins;
+}
+
+static const float *LoadBins(const float *data, const float *scale, const HeadView<false> &view, int n, float *bins)
+{
+    if (!scale)
+        return data;
+    DequantizeScaled(data, scale, bins, n);
+    return bins;
+}
+
+/**
+ * Phase 2:box of every candidate of ClassScan,each side the softmax
+ * expectation of its reg_max bins in cells,mapped to model input pixels
+ * through the plan tables.
+ */
+struct BoxDecode
+{
+    const YoloDflConfig *config;
+    const YoloDecodePlan *plan;
+    const YoloDecodeLayer *layer_plan;
+    float score_threshold;
+    const int *cells;
+    const int *ids;
+    const float *logits;
+    int count;
+    float *bins;
+    DetectionBatch *results;
+
+    template <class T, bool kPlanar>
+    void operator()(const T *data, const float *scale, const HeadView<kPlanar> &view)
+    {
+        const int reg_max = config->reg_max;
+        const int width = layer_plan->width;
+        for (int c = 0; c < count; c++)
+        {
+            float confidence = Sigmoid<KernelAccuracy::kExact>(logits[c]);
+            if (confidence < score_threshold)
+            {
+                continue;
+            }
+            int h = cells[c] / width;
+            int w = cells[c] % width;
+            const float *side = LoadBins(data + view.Offset(h, w, 0), scale, view, 4 * reg_max, bins);
+            float left = SoftmaxExpectation<KernelAccuracy::kFast>(side, reg_max);
+            float top = SoftmaxExpectation<KernelAccuracy::kFast>(side + reg_max, reg_max);
+            float right = SoftmaxExpectation<KernelAccuracy::kFast>(side + 2 * reg_max, reg_max);
+            float bottom = SoftmaxExpectation<KernelAccuracy::kFast>(side + 3 * reg_max, reg_max);
+
+            float xmin = layer_plan->grid_x[w] - layer_plan->xy_gain_x * left;
+            float ymin = layer_plan->grid_y[h] - layer_plan->xy_gain_y * top;
+            float xmax = layer_plan->grid_x[w] + layer_plan->xy_gain_x * right;
+            float ymax = layer_plan->grid_y[h] + layer_plan->xy_gain_y * bottom;
+            //nothing of it inside the model input,whatever the pre processing was
+            if (xmax <= 0.0f || ymax <= 0.0f)
+            {
+                continue;
+            }
+
+            results->Push(ids[c], xmin, ymin, xmax, ymax, confidence);
+        }
+    }
+};
+
+int DflYoloDecoder::BuildPlan(const YoloDflConfig &config, const hbDNNTensor *tensors,
+                              const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+{
+    size_t layer_num = config.strides.size();
+    std::vector<int> heights(layer_num), widths(layer_num);
+    for (size_t i = 0; i < layer_num; i++)
+    {
+        int channels, box_height, box_width, box_channels;
+        if (HeadShape(&tensors[2 * i], &heights[i], &widths[i], &channels) != 0 ||
+            HeadShape(&tensors[2 * i + 1], &box_height, &box_width, &box_channels) != 0)
+        {
+            printf("yolo dfl head %zu: unsupported tensor layout\n", i);
+            return -1;
+        }
+        if (channels != config.class_num || box_channels != 4 * config.reg_max ||
+            box_height != heights[i] || box_width != widths[i])
+        {
+            printf("yolo dfl head %zu: %dx%dx%d classes,%dx%dx%d box bins,expected %d classes,%d bins\n", i,
+                   heights[i], widths[i], channels, box_height, box_width, box_channels, config.class_num,
+                   4 * config.reg_max);
+            return -1;
+        }
+    }
+    //anchor free,a cell predicts distances from its center,one unused anchor
+    //per cell gives the center tables
+    std::vector<std::vector<std::pair<double, double>>> anchors_table(layer_num, {{0.0, 0.0}});
+    YoloBoxCoding coding = {1.0f, 0.5f, 1.0f, true};
+    return BuildYoloDecodePlan(image_info, config.strides, anchors_table, heights, widths, coding, plan);
+}
+
+void DflYoloDecoder::ParseHead(const YoloDflConfig &config, float score_threshold, const hbDNNTensor *tensors,
+                               const YoloDecodePlan &plan, int layer, DetectionBatch &results)
+{
+    const YoloDecodeLayer &layer_plan = plan.layers[layer];
+    int cell_num = layer_plan.height * layer_plan.width;
+    FrameArena &arena = FrameArena::ThisThread();
+    ArenaScope scope(arena);
+
+    ClassScan scan;
+    scan.height = layer_plan.height;
+    scan.width = layer_plan.width;
+    scan.num_classes = config.class_num;
+    //sigmoid(x) >= threshold <=> x >= log(threshold / (1 - threshold))
+    scan.logit_threshold = std::log(score_threshold / (1 - score_threshold));
+    scan.cells = arena.Alloc<int>(cell_num);
+    scan.ids = arena.Alloc<int>(cell_num);
+    scan.logits = arena.Alloc<float>(cell_num);
+    scan.count = 0;
+    const hbDNNTensor *class_tensor = &tensors[2 * layer];
+    if (!VisitTensor(class_tensor, scan))
+    {
+        printf("yolo dfl unsupported class output: quanti_type %d,tensor_type %d,layout %d\n",
+               class_tensor->properties.quantiType, class_tensor->properties.tensorType,
+               class_tensor->properties.tensorLayout);
+        return;
+    }
+    if (scan.count == 0)
+        return;
+
+    results.Reserve(results.Size() + scan.count);
+    results.SetClassNames(&config.class_names);
+    BoxDecode decode;
+    decode.config = &config;
+    decode.plan = &plan;
+    decode.layer_plan = &layer_plan;
+    decode.score_threshold = score_threshold;
+    decode.cells = scan.cells;
+    decode.ids = scan.ids;
+    decode.logits = scan.logits;
+    decode.count = scan.count;
+    decode.bins = arena.Alloc<float>(4 * config.reg_max);
+    decode.results = &results;
+    const hbDNNTensor *box_tensor = &tensors[2 * layer + 1];
+    if (!VisitTensor(box_tensor, decode))
+    {
+        printf("yolo dfl unsupported box output: quanti_type %d,tensor_type %d,layout %d\n",
+               box_tensor->properties.quantiType, box_tensor->properties.tensorType,
+               box_tensor->properties.tensorLayout);
+    }
+}
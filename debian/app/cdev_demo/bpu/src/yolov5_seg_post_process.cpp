@@ -0,0 +1,258 @@
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include "yolov5_seg_post_process.hpp"
+#include "frame_arena.hpp"
+#include "nms_engine.hpp"
+
+PTQYolo5SegConfig yolo5_seg_config_ = {
+    {8, 16, 32},
+    {{{10, 13}, {16, 30}, {33, 23}},
+     {{30, 61}, {62, 45}, {59, 119}},
+     {{116, 90}, {156, 198}, {373, 326}}},
+    80,
+    {"person", "bicycle", "car",
+     "motorcycle", "airplane", "bus",
+     "train", "truck", "boat",
+     "traffic light", "fire hydrant", "stop sign",
+     "parking meter", "bench", "bird",
+     "cat", "dog", "horse",
+     "sheep", "cow", "elephant",
+     "bear", "zebra", "giraffe",
+     "backpack", "umbrella", "handbag",
+     "tie", "suitcase", "frisbee",
+     "skis", "snowboard", "sports ball",
+     "kite", "baseball bat", "baseball glove",
+     "skateboard", "surfboard", "tennis racket",
+     "bottle", "wine glass", "cup",
+     "fork", "knife", "spoon",
+     "bowl", "banana", "apple",
+     "sandwich", "orange", "broccoli",
+     "carrot", "hot dog", "pizza",
+     "donut", "cake", "chair",
+     "couch", "potted plant", "bed",
+     "dining table", "toilet", "tv",
+     "laptop", "mouse", "remote",
+     "keyboard", "cell phone", "microwave",
+     "oven", "toaster", "sink",
+     "refrigerator", "book", "clock",
+     "vase", "scissors", "teddy bear",
+     "hair drier", "toothbrush"},
+    yolov5_seg_mask_dim_};
+
+typedef AnchorYoloDecoder<Yolov5BoxPolicy> Yolov5SegDecoder;
+
+void yolov5_seg_ParseTensor(const hbDNNTensor *tensor,
+                            const YoloDecodePlan &plan,
+                            int layer,
+                            DetectionBatch &results)
+{
+    Yolov5SegDecoder::ParseTensor(yolo5_seg_config_, yolov5_seg_score_threshold_, tensor, plan, layer, results);
+}
+
+int yolov5_seg_BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+{
+    return Yolov5SegDecoder::BuildPlan(yolo5_seg_config_, tensors, image_info, plan);
+}
+
+void yolov5_seg_nms(const DetectionBatch &input,
+                    float iou_threshold,
+                    int top_k,
+                    DetectionBatch &result,
+                    bool suppress)
+{
+    NmsParams params = {iou_threshold, top_k, suppress, yolov5_seg_nms_grid_candidates_};
+    NmsBatch(input, params, result);
+}
+
+/**
+ * Prototype cells [x0, x0 + width) x [y0, y0 + height) of one detection.
+ */
+struct MaskRoi
+{
+    int x0;
+    int y0;
+    int width;
+    int height;
+};
+
+/**
+ * logits[y][x] = coefficients . proto[y0 + y][x0 + x],a gemv of the roi
+ * cells against the coefficients. NHWC takes one dot product per cell,
+ * NCHW accumulates a row of every prototype plane at a time. A SCALE
+ * quantized proto is read raw with its scale folded into the weights.
+ */
+template <class T, bool kPlanar>
+static void RoiLogits(const T *data, const float *scale, const HeadView<kPlanar> &view, const MaskRoi &roi,
+                      const float *coefficients, float *weights, float *logits)
+{
+    for (int c = 0; c < yolov5_seg_mask_dim_; c++)
+    {
+        weights[c] = scale ? coefficients[c] * scale[c] : coefficients[c];
+    }
+    if (!kPlanar)
+    {
+        for (int y = 0; y < roi.height; y++)
+        {
+            for (int x = 0; x < roi.width; x++)
+            {
+                logits[y * roi.width + x] = Dot(data + view.Offset(roi.y0 + y, roi.x0 + x, 0), weights, yolov5_seg_mask_dim_);
+            }
+        }
+        return;
+    }
+    std::fill(logits, logits + roi.width * roi.height, 0.0f);
+    for (int c = 0; c < yolov5_seg_mask_dim_; c++)
+    {
+        for (int y = 0; y < roi.height; y++)
+        {
+            Axpy(weights[c], data + view.Offset(roi.y0 + y, roi.x0, c), logits + y * roi.width, roi.width);
+        }
+    }
+}
+
+template <class T>
+static bool RoiLogitsOfLayout(const T *data, const float *scale, const hbDNNTensor *proto, const MaskRoi &roi,
+                              const float *coefficients, float *weights, float *logits)
+{
+    HeadView<false> nhwc;
+    HeadView<true> nchw;
+    if (nhwc.Init(proto->properties, sizeof(T)))
+        RoiLogits(data, scale, nhwc, roi, coefficients, weights, logits);
+    else if (nchw.Init(proto->properties, sizeof(T)))
+        RoiLogits(data, scale, nchw, roi, coefficients, weights, logits);
+    else
+        return false;
+    return true;
+}
+
+static bool ProtoRoiLogits(const hbDNNTensor *proto, const MaskRoi &roi, const float *coefficients, float *weights,
+                           float *logits)
+{
+    const hbDNNTensorProperties &properties = proto->properties;
+    void *data = proto->sysMem[0].virAddr;
+    if (properties.quantiType == NONE)
+        return RoiLogitsOfLayout(reinterpret_cast<const float *>(data), nullptr, proto, roi, coefficients, weights, logits);
+    if (properties.quantiType != SCALE)
+        return false;
+    const float *scale = properties.scale.scaleData;
+    switch (properties.tensorType)
+    {
+    case HB_DNN_TENSOR_TYPE_S8:
+        return RoiLogitsOfLayout(reinterpret_cast<const int8_t *>(data), scale, proto, roi, coefficients, weights, logits);
+    case HB_DNN_TENSOR_TYPE_S16:
+        return RoiLogitsOfLayout(reinterpret_cast<const int16_t *>(data), scale, proto, roi, coefficients, weights, logits);
+    case HB_DNN_TENSOR_TYPE_S32:
+        return RoiLogitsOfLayout(reinterpret_cast<const int32_t *>(data), scale, proto, roi, coefficients, weights, logits);
+    default:
+        return false;
+    }
+}
+
+/**
+ * Bilinear taps of display pixels first~first+count-1 along one axis,
+ * relative to the roi cells [roi_first, roi_last].
+ */
+static void AxisTaps(int first, int count, double to_proto, double proto_offset, int roi_first, int roi_last,
+                     int *tap0, int *tap1, float *weight)
+{
+    for (int i = 0; i < count; i++)
+    {
+        double position = (first + i + 0.5) * to_proto + proto_offset - 0.5; //pixel center in prototype cells
+        position = std::min(std::max(position, (double)roi_first), (double)roi_last);
+        int cell = std::min((int)position, std::max(roi_last - 1, roi_first));
+        tap0[i] = cell - roi_first;
+        tap1[i] = std::min(cell + 1, roi_last) - roi_first;
+        weight[i] = position - cell;
+    }
+}
+
+int yolov5_seg_BuildMasks(const hbDNNTensor *proto,
+                          const bpu_image_info_t &image_info,
+                          const CoordMapping &mapping,
+                          InstanceSegmentation &results)
+{
+    const DetectionBatch &detections = results.detections;
+    results.masks.clear();
+    results.pixels.clear();
+    const hbDNNTensorProperties &properties = proto->properties;
+    bool nchw = properties.tensorLayout == HB_DNN_LAYOUT_NCHW;
+    int proto_h = properties.validShape.dimensionSize[nchw ? 2 : 1];
+    int proto_w = properties.validShape.dimensionSize[nchw ? 3 : 2];
+    int channels = properties.validShape.dimensionSize[nchw ? 1 : 3];
+    if (channels != yolov5_seg_mask_dim_ || proto_h <= 0 || proto_w <= 0)
+    {
+        printf("yolov5 seg proto: %dx%dx%d,expected %d channels\n", proto_h, proto_w, channels, yolov5_seg_mask_dim_);
+        return -1;
+    }
+
+    //display -> model -> prototype cells,the inverse of mapping
+    double to_proto_x = proto_w / (image_info.m_model_w * (double)mapping.scale_x);
+    double to_proto_y = proto_h / (image_info.m_model_h * (double)mapping.scale_y);
+    double proto_offset_x = -mapping.offset_x * to_proto_x;
+    double proto_offset_y = -mapping.offset_y * to_proto_y;
+
+    FrameArena &arena = FrameArena::ThisThread();
+    ArenaScope scope(arena);
+    float *weights = arena.Alloc<float>(yolov5_seg_mask_dim_);
+    for (int i = 0; i < detections.Size(); i++)
+    {
+        InstanceMask mask;
+        mask.x = std::max((int)floorf(detections.XMin()[i]), 0);
+        mask.y = std::max((int)floorf(detections.YMin()[i]), 0);
+        mask.width = std::max(std::min((int)ceilf(detections.XMax()[i]), image_info.m_ori_width) - mask.x, 0);
+        mask.height = std::max(std::min((int)ceilf(detections.YMax()[i]), image_info.m_ori_height) - mask.y, 0);
+        mask.offset = results.pixels.size();
+        results.masks.push_back(mask);
+        if (mask.width == 0 || mask.height == 0)
+            continue;
+
+        //prototype cells under the box,plus the neighbours bilinear taps reach
+        MaskRoi roi;
+        roi.x0 = std::max((int)floor((mask.x + 0.5) * to_proto_x + proto_offset_x - 0.5), 0);
+        roi.y0 = std::max((int)floor((mask.y + 0.5) * to_proto_y + proto_offset_y - 0.5), 0);
+        int roi_x1 = std::min((int)floor((mask.x + mask.width - 0.5) * to_proto_x + proto_offset_x - 0.5) + 1, proto_w - 1);
+        int roi_y1 = std::min((int)floor((mask.y + mask.height - 0.5) * to_proto_y + proto_offset_y - 0.5) + 1, proto_h - 1);
+        roi.x0 = std::min(roi.x0, roi_x1);
+        roi.y0 = std::min(roi.y0, roi_y1);
+        roi.width = roi_x1 - roi.x0 + 1;
+        roi.height = roi_y1 - roi.y0 + 1;
+
+        ArenaScope detection_scope(arena);
+        float *logits = arena.Alloc<float>(roi.width * roi.height);
+        if (!ProtoRoiLogits(proto, roi, detections.Extra(i), weights, logits))
+        {
+            printf("yolov5 seg unsupported proto: quanti_type %d,tensor_type %d,layout %d\n",
+                   properties.quantiType, properties.tensorType, properties.tensorLayout);
+            results.masks.back().width = 0;
+            results.masks.back().height = 0;
+            return -1;
+        }
+        int *col0 = arena.Alloc<int>(mask.width);
+        int *col1 = arena.Alloc<int>(mask.width);
+        float *col_weight = arena.Alloc<float>(mask.width);
+        int *row0 = arena.Alloc<int>(mask.height);
+        int *row1 = arena.Alloc<int>(mask.height);
+        float *row_weight = arena.Alloc<float>(mask.height);
+        AxisTaps(mask.x, mask.width, to_proto_x, proto_offset_x, roi.x0, roi_x1, col0, col1, col_weight);
+        AxisTaps(mask.y, mask.height, to_proto_y, proto_offset_y, roi.y0, roi_y1, row0, row1, row_weight);
+
+        //sigmoid(x) > 0.5 <=> x > 0,the logits are interpolated and only their sign is kept
+        results.pixels.resize(mask.offset + (size_t)mask.width * mask.height);
+        uint8_t *out = results.pixels.data() + mask.offset;
+        for (int y = 0; y < mask.height; y++)
+        {
+            const float *top = logits + row0[y] * roi.width;
+            const float *bottom = logits + row1[y] * roi.width;
+            float wy = row_weight[y];
+            for (int x = 0; x < mask.width; x++)
+            {
+                float upper = top[col0[x]] + (top[col1[x]] - top[col0[x]]) * col_weight[x];
+                float lower = bottom[col0[x]] + (bottom[col1[x]] - bottom[col0[x]]) * col_weight[x];
+                out[x] = upper + (lower - upper) * wy > 0;
+            }
+            out += mask.width;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "yolov8_post_process.hpp"
+
+PTQYolo8Config yolo8_config_ = {
+    {8, 16, 32},
+    16,
+    80,
+    {"person", "bicycle", "car",
+     "motorcycle", "airplane", "bus",
+     "train", "truck", "boat",
+     "traffic light", "fire hydrant", "stop sign",
+     "parking meter", "bench", "bird",
+     "cat", "dog", "horse",
+     "sheep", "cow", "elephant",
+     "bear", "zebra", "giraffe",
+     "backpack", "umbrella", "handbag",
+     "tie", "suitcase", "frisbee",
+     "skis", "snowboard", "sports ball",
+     "kite", "baseball bat", "baseball glove",
+     "skateboard", "surfboard", "tennis racket",
+     "bottle", "wine glass", "cup",
+     "fork", "knife", "spoon",
+     "bowl", "banana", "apple",
+     "sandwich", "orange", "broccoli",
+     "carrot", "hot dog", "pizza",
+     "donut", "cake", "chair",
+     "couch", "potted plant", "bed",
+     "dining table", "toilet", "tv",
+     "laptop", "mouse", "remote",
+     "keyboard", "cell phone", "microwave",
+     "oven", "toaster", "sink",
+     "refrigerator", "book", "clock",
+     "vase", "scissors", "teddy bear",
+     "hair drier", "toothbrush"}};
+
+
+void yolov8_ParseTensor(const hbDNNTensor *tensors,
+                        const YoloDecodePlan &plan,
+                        int layer,
+                        DetectionBatch &results)
+{
+    DflYoloDecoder::ParseHead(yolo8_config_, yolov8_score_threshold_, tensors, plan, layer, results);
+}
+
+int yolov8_BuildDecodePlan(const hbDNNTensor *tensors, const bpu_image_info_t &image_info, YoloDecodePlan &plan)
+{
+    return DflYoloDecoder::BuildPlan(yolo8_config_, tensors, image_info, plan);
+}